@@ -1,7 +1,42 @@
 #include "animator.hpp"
 
 namespace {
+  constexpr uint64_t per_millisecond = 1000;
+
+  bool later(const timeline::cue& a, const timeline::cue& b) noexcept {
+    return a.due > b.due;
+  }
+
+  // An animation with no time in any of its frames never changes, so it is never put on the timeline;
+  // timing one would re-enqueue it at the same instant forever.
+  bool still(const atlas::animation& anim, std::span<const uint32_t> durations) noexcept {
+    const auto frames = durations.subspan(anim.offset, anim.count);
+    return std::ranges::all_of(frames, [](uint32_t duration) { return duration == 0; });
+  }
+
+  // A collidable's body only needs a sync when the new keyframe has a different outline.
+  void reshape(entt::registry& registry, const atlas& a, entt::entity entity, uint32_t from, uint32_t to) {
+    if (a.outline(from) == a.outline(to) || !registry.all_of<collidable>(entity)) return;
+
+    registry.emplace_or_replace<displaced>(entity);
+  }
+
+  void resize(entt::registry& registry, const atlas& a, entt::entity entity, uint32_t from, uint32_t to) {
+    const auto& before = a.sprites()[from];
+    const auto& after = a.sprites()[to];
+    if (before.w == after.w && before.h == after.h) return;
+
+    registry.emplace_or_replace<moved>(entity);
+  }
+
+  void enqueue(timeline& tl, entt::entity entity, uint32_t stamp, uint64_t due) {
+    tl.heap.push_back({due, entity, stamp});
+    std::ranges::push_heap(tl.heap, later);
+  }
+
   void dispatch_animation_end(entt::registry& registry, entt::entity entity, entt::id_type name) {
+    if (!registry.valid(entity)) return;
+
     const auto* s = registry.try_get<scriptable>(entity);
     if (!s || s->on_animation_end == LUA_NOREF) return;
 
@@ -20,37 +55,77 @@ namespace {
   }
 }
 
+// Starts timing the entity's current frame from now, superseding whatever was scheduled for it before.
+void animator::schedule(entt::registry& registry, const atlasregistry& atlasregistry, entt::entity entity) {
+  auto& tl = registry.ctx().get<timeline>();
+  auto& r = registry.get<renderable>(entity);
+  ++r.stamp;
+
+  const auto& a = atlasregistry.at(r.atlas);
+  const auto durations = a.durations();
+  const auto& anim = a.at(r.animation);
+  if (still(anim, durations)) return;
+
+  enqueue(tl, entity, r.stamp, tl.now + durations[anim.offset + r.current_frame] * per_millisecond);
+}
+
+// Only entities whose frame is due are visited; animation end callbacks run after the pass, once the timeline is consistent.
 void animator::update(entt::registry& registry, atlasregistry& atlasregistry, float delta) {
-  for (auto&& [entity, r] : registry.view<renderable>().each()) {
-    const auto* anim = atlasregistry.get(r.atlas).find(r.entry);
-    if (!anim || anim->keyframes.empty()) [[unlikely]] continue;
-
-    if (anim->keyframes.size() == 1 && anim->keyframes[0].duration == 0) [[unlikely]] continue;
-
-    r.counter += delta * 1000.f;
-
-    while (r.counter >= static_cast<float>(anim->keyframes[r.current_frame].duration)) {
-      r.counter -= static_cast<float>(anim->keyframes[r.current_frame].duration);
-
-      if (r.current_frame + 1 < static_cast<uint32_t>(anim->keyframes.size())) {
-        ++r.current_frame;
-      } else if (anim->next != 0) {
-        const auto finished_entry = r.entry;
-        r.entry = anim->next;
-        r.current_frame = 0;
-        r.counter = .0f;
-        dispatch_animation_end(registry, entity, finished_entry);
-
-        anim = atlasregistry.get(r.atlas).find(r.entry);
-        if (!anim || anim->keyframes.empty()) [[unlikely]] break;
-      } else if (anim->once) {
-        r.counter = .0f;
-        dispatch_animation_end(registry, entity, r.entry);
-        break;
-      } else {
-        r.current_frame = 0;
-        dispatch_animation_end(registry, entity, r.entry);
-      }
+  auto& tl = registry.ctx().get<timeline>();
+  auto& ls = registry.ctx().get<layers>();
+  auto& ended = tl.ended;
+
+  // Cleared up front, so a callback that threw last time cannot leave entries behind.
+  ended.clear();
+
+  tl.now += static_cast<uint64_t>(std::llround(static_cast<double>(delta) * 1'000'000.0));
+
+  while (!tl.heap.empty() && tl.heap.front().due <= tl.now) {
+    std::ranges::pop_heap(tl.heap, later);
+    const auto c = tl.heap.back();
+    tl.heap.pop_back();
+
+    if (!registry.valid(c.entity)) continue;
+
+    auto* r = registry.try_get<renderable>(c.entity);
+    if (!r || r->stamp != c.stamp) continue;
+
+    const auto& a = atlasregistry.at(r->atlas);
+    const auto durations = a.durations();
+    const auto& anim = a.at(r->animation);
+
+    const auto from = a.keyframe(r->animation, r->current_frame);
+
+    // The overshoot carries into the next frame, except across a chained animation, which starts afresh.
+    auto due = c.due;
+
+    if (r->current_frame + 1 < anim.count) {
+      ++r->current_frame;
+    } else if (anim.next != atlas::none) {
+      ended.emplace_back(c.entity, anim.id);
+      r->animation = anim.next;
+      r->current_frame = 0;
+      due = tl.now;
+    } else if (anim.once) {
+      ended.emplace_back(c.entity, anim.id);
+      continue;
+    } else {
+      r->current_frame = 0;
+      ended.emplace_back(c.entity, anim.id);
     }
+
+    ls.touch(registry, c.entity);
+    const auto to = a.keyframe(r->animation, r->current_frame);
+    reshape(registry, a, c.entity, from, to);
+    resize(registry, a, c.entity, from, to);
+
+    const auto& current = a.at(r->animation);
+    if (still(current, durations)) continue;
+
+    enqueue(tl, c.entity, r->stamp, due + durations[current.offset + r->current_frame] * per_millisecond);
+  }
+
+  for (const auto& [entity, name] : ended) {
+    dispatch_animation_end(registry, entity, name);
   }
 }
@@ -5,5 +5,7 @@
 class atlasregistry;
 
 namespace animator {
+  void schedule(entt::registry& registry, const atlasregistry& atlasregistry, entt::entity entity);
+
   void update(entt::registry& registry, atlasregistry& atlasregistry, float delta);
 }
@@ -6,11 +6,149 @@ namespace {
   constexpr int field_w = 3;
   constexpr int field_h = 4;
 
+  // Binary index written by pincel-pack next to each page as <name>.idx: a header, then the
+  // animation table, then every keyframe with its UVs already normalised, then the hitboxes
+  // the keyframes point into, all little-endian.
+  struct header final {
+    std::array<char, 4> magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t animations;
+    uint32_t keyframes;
+    uint32_t boxes;
+  };
+
+  static_assert(sizeof(header) == 24);
+
+  struct record final {
+    entt::id_type id;
+    uint32_t offset;
+    uint32_t count;
+    uint32_t next;
+    uint32_t once;
+  };
+
+  static_assert(sizeof(record) == 20);
+
+  struct frame final {
+    float u0, v0, u1, v1;
+    float w, h;
+    uint32_t first;
+    uint32_t count;
+    uint32_t duration;
+  };
+
+  static_assert(sizeof(frame) == 36);
+  static_assert(sizeof(atlas::hitbox) == 16);
+
+  constexpr std::array<char, 4> signature{'P', 'A', 'I', '2'};
+
   entt::id_type hash(std::string_view value) {
     return entt::hashed_string::value(value.data(), value.size());
   }
 
-  atlas::sprite parse_sprite(float fw, float fh, uint32_t fields) {
+  uint64_t digest(std::span<const uint8_t> data) noexcept {
+    auto h = 0xcbf29ce484222325ull;
+    for (const auto byte : data) {
+      h ^= byte;
+      h *= 0x100000001b3ull;
+    }
+    return h ^ data.size();
+  }
+
+  pixmap inflate(std::span<const uint8_t> png) {
+    auto spng =
+      std::unique_ptr<spng_ctx, SPNG_Deleter>(spng_ctx_new(SPNG_CTX_IGNORE_ADLER32));
+
+    spng_set_crc_action(spng.get(), SPNG_CRC_USE, SPNG_CRC_USE);
+    spng_set_png_buffer(spng.get(), png.data(), png.size());
+
+    spng_ihdr ihdr;
+    spng_get_ihdr(spng.get(), &ihdr);
+
+    size_t length;
+    spng_decoded_image_size(spng.get(), SPNG_FMT_RGBA8, &length);
+
+    auto pixels = std::make_unique_for_overwrite<uint8_t[]>(length);
+    spng_decode_image(spng.get(), pixels.get(), length, SPNG_FMT_RGBA8, SPNG_DECODE_TRNS);
+
+    return pixmap{ihdr.width, ihdr.height, std::move(pixels)};
+  }
+
+  // The per-user writable directory, since the working directory of a bundle or shortcut launch may be read-only.
+  const std::filesystem::path& cache() {
+    static const auto directory = [] {
+      const std::unique_ptr<char, SDL_Deleter> base(SDL_GetPrefPath("willtobyte", "pincel"));
+      if (!base) return std::filesystem::path{};
+
+      auto path = std::filesystem::path{base.get()} / "cache";
+      std::error_code ec;
+      std::filesystem::create_directories(path, ec);
+      return ec ? std::filesystem::path{} : path;
+    }();
+
+    return directory;
+  }
+
+  // Raw RGBA is large (64 MB for a 4096² page), so the cache keeps at most this much and drops the least recently used.
+  constexpr uintmax_t quota = uintmax_t{512} << 20;
+
+  // Runs after every write; decode workers serialise here so two of them never race over the same entries.
+  void prune(const std::filesystem::path& directory) {
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
+
+    struct entry final {
+      std::filesystem::path path;
+      std::filesystem::file_time_type time;
+      uintmax_t size;
+    };
+
+    std::vector<entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(directory, ec)) {
+      if (file.path().extension() != ".pxm") continue;
+
+      const auto size = file.file_size(ec);
+      if (ec) continue;
+
+      const auto time = file.last_write_time(ec);
+      if (ec) continue;
+
+      entries.push_back({file.path(), time, size});
+      total += size;
+    }
+
+    if (total <= quota) return;
+
+    std::ranges::sort(entries, {}, &entry::time);
+    for (const auto& e : entries) {
+      if (total <= quota) break;
+      if (std::filesystem::remove(e.path, ec)) total -= e.size;
+    }
+  }
+
+  // Decoded RGBA is cached on disk under the PNG's content hash and mapped back on later launches.
+  pixmap load(std::span<const uint8_t> png) {
+    const auto& directory = cache();
+    if (directory.empty()) return inflate(png);
+
+    const auto path = directory / std::format("{:016x}.pxm", digest(png));
+    if (auto cached = pixmap::map(path)) {
+      // A hit refreshes the entry's age, so pruning evicts what no recent launch has used.
+      std::error_code ec;
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+      return std::move(*cached);
+    }
+
+    auto image = inflate(png);
+    image.save(path);
+    prune(directory);
+    return image;
+  }
+
+  atlas::sprite parse_sprite(float fw, float fh) {
     atlas::sprite s{};
 
     lua_rawgeti(L, -1, field_x);
@@ -36,63 +174,132 @@ namespace {
     s.w = w;
     s.h = h;
 
-    if (fields >= 8) {
-      lua_rawgeti(L, -1, 5);
-      s.hx = static_cast<float>(lua_tonumber(L, -1));
-      lua_pop(L, 1);
+    return s;
+  }
 
-      lua_rawgeti(L, -1, 6);
-      s.hy = static_cast<float>(lua_tonumber(L, -1));
-      lua_pop(L, 1);
+  // Reads the hitboxes that follow x, y, w, h, four fields each, and returns how many there were.
+  uint32_t parse_hitboxes(std::string_view name, uint32_t fields, std::vector<atlas::hitbox>& out) {
+    assert((fields - field_h) % 4 == 0 && "hitboxes must be given as hx, hy, hw, hh");
 
-      lua_rawgeti(L, -1, 7);
-      s.hw = static_cast<float>(lua_tonumber(L, -1));
-      lua_pop(L, 1);
+    uint32_t count = 0;
+    for (auto field = field_h + 1; field + 3 <= static_cast<int>(fields); field += 4, ++count) {
+      float values[4];
+      for (int i = 0; i < 4; ++i) {
+        lua_rawgeti(L, -1, field + i);
+        values[i] = static_cast<float>(lua_tonumber(L, -1));
+        lua_pop(L, 1);
+      }
 
-      lua_rawgeti(L, -1, 8);
-      s.hh = static_cast<float>(lua_tonumber(L, -1));
-      lua_pop(L, 1);
+      out.push_back({values[0], values[1], values[2], values[3]});
     }
 
-    return s;
+    if (count > atlas::capacity) [[unlikely]]
+      throw std::runtime_error(std::format("atlas {} keyframe has more than {} hitboxes", name, atlas::capacity));
+
+    return count;
+  }
+
+  // Box2D does not scale shapes, so a polygon is scaled about the body origin by hand.
+  b2Polygon scale(const b2Polygon& polygon, float factor) noexcept {
+    auto result = polygon;
+    for (int i = 0; i < result.count; ++i) {
+      result.vertices[i] = b2MulSV(factor, polygon.vertices[i]);
+    }
+
+    result.centroid = b2MulSV(factor, polygon.centroid);
+    result.radius = polygon.radius * factor;
+    return result;
   }
 }
 
-atlas::atlas(std::string_view name) {
-  const auto png = io::read(std::format("blobs/atlas/{}.png", name));
+pixmap atlas::decode(std::string_view name) {
+  return load(io::read(std::format("blobs/atlas/{}.png", name)));
+}
 
-  auto spng =
-    std::unique_ptr<spng_ctx, SPNG_Deleter>(spng_ctx_new(SPNG_CTX_IGNORE_ADLER32));
+atlas::atlas(std::string_view name)
+    : _name(name) {
+  const auto filename = std::format("blobs/atlas/{}.idx", name);
+  if (io::exists(filename))
+    index(io::read(filename));
+  else
+    script(name);
+}
 
-  spng_set_crc_action(spng.get(), SPNG_CRC_USE, SPNG_CRC_USE);
-  spng_set_png_buffer(spng.get(), png.data(), png.size());
+void atlas::index(std::span<const uint8_t> buffer) {
+  header h;
+  if (buffer.size() < sizeof(h)) [[unlikely]]
+    throw std::runtime_error(std::format("atlas index {} is truncated", _name));
+
+  std::memcpy(&h, buffer.data(), sizeof(h));
+  if (h.magic != signature) [[unlikely]]
+    throw std::runtime_error(std::format("atlas index {} has an unknown format", _name));
+
+  const auto animations = sizeof(h);
+  const auto keyframes = animations + sizeof(record) * h.animations;
+  const auto boxes = keyframes + sizeof(frame) * h.keyframes;
+  if (buffer.size() != boxes + sizeof(hitbox) * h.boxes) [[unlikely]]
+    throw std::runtime_error(std::format("atlas index {} is truncated", _name));
+
+  _width = h.width;
+  _height = h.height;
+
+  _animations.resize(h.animations);
+  _lookup.reserve(h.animations);
+
+  for (uint32_t i = 0; i < h.animations; ++i) {
+    record r;
+    std::memcpy(&r, buffer.data() + animations + sizeof(r) * i, sizeof(r));
+    if (r.offset > h.keyframes || r.count > h.keyframes - r.offset) [[unlikely]]
+      throw std::runtime_error(std::format("atlas index {} animation {} keyframes out of bounds", _name, i));
+    if (r.next != none && r.next >= h.animations) [[unlikely]]
+      throw std::runtime_error(std::format("atlas index {} animation {} next out of bounds", _name, i));
+
+    _animations[i] = {r.id, r.offset, r.count, r.next, r.once != 0};
+    _lookup.emplace(r.id, i);
+  }
 
-  spng_ihdr ihdr;
-  spng_get_ihdr(spng.get(), &ihdr);
+  _sprites.resize(h.keyframes);
+  _durations.resize(h.keyframes);
 
-  const auto tw = static_cast<int>(ihdr.width);
-  const auto th = static_cast<int>(ihdr.height);
+  std::vector<hitbox> hitboxes(h.boxes);
+  std::memcpy(hitboxes.data(), buffer.data() + boxes, sizeof(hitbox) * h.boxes);
 
-  [[maybe_unused]] const auto maximum = static_cast<int>(SDL_GetNumberProperty(
-    SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0));
-  assert(tw <= maximum && "texture width exceeds GPU maximum texture size");
-  assert(th <= maximum && "texture height exceeds GPU maximum texture size");
+  std::vector<uint32_t> firsts(h.keyframes);
+  std::vector<uint32_t> counts(h.keyframes);
 
-  size_t length;
-  spng_decoded_image_size(spng.get(), SPNG_FMT_RGBA8, &length);
+  for (uint32_t k = 0; k < h.keyframes; ++k) {
+    frame f;
+    std::memcpy(&f, buffer.data() + keyframes + sizeof(f) * k, sizeof(f));
+    if (f.first > h.boxes || f.count > h.boxes - f.first) [[unlikely]]
+      throw std::runtime_error(std::format("atlas index {} keyframe {} hitboxes out of bounds", _name, k));
+    if (f.count > capacity) [[unlikely]]
+      throw std::runtime_error(std::format("atlas index {} keyframe {} has more than {} hitboxes", _name, k, capacity));
 
-  auto pixels = std::make_unique_for_overwrite<uint8_t[]>(length);
-  spng_decode_image(spng.get(), pixels.get(), length, SPNG_FMT_RGBA8, SPNG_DECODE_TRNS);
+    _sprites[k] = {f.u0, f.v0, f.u1, f.v1, f.w, f.h};
+    _durations[k] = f.duration;
+    firsts[k] = f.first;
+    counts[k] = f.count;
+  }
 
-  _texture = std::unique_ptr<SDL_Texture, SDL_Deleter>(
-    SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, tw, th));
+  trace(hitboxes, firsts, counts);
+}
 
-  SDL_UpdateTexture(_texture.get(), nullptr, pixels.get(), tw * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_RGBA32));
-  SDL_SetTextureScaleMode(_texture.get(), SDL_SCALEMODE_NEAREST);
-  SDL_SetTextureBlendMode(_texture.get(), SDL_BLENDMODE_BLEND);
+void atlas::script(std::string_view name) {
+  const auto header = io::peek(std::format("blobs/atlas/{}.png", name), 24);
+  assert(header.size() == 24 && "atlas png is truncated");
+
+  const auto be32 = [&](size_t offset) {
+    return static_cast<uint32_t>(header[offset]) << 24
+         | static_cast<uint32_t>(header[offset + 1]) << 16
+         | static_cast<uint32_t>(header[offset + 2]) << 8
+         | static_cast<uint32_t>(header[offset + 3]);
+  };
 
-  const auto fw = static_cast<float>(tw);
-  const auto fh = static_cast<float>(th);
+  _width = be32(16);
+  _height = be32(20);
+
+  const auto fw = static_cast<float>(_width);
+  const auto fh = static_cast<float>(_height);
 
   const auto filename = std::format("blobs/atlas/{}.lua", name);
   const auto buffer = io::read(filename);
@@ -109,6 +316,10 @@ atlas::atlas(std::string_view name) {
 
   assert(lua_istable(L, -1) && "atlas lua must return a table");
 
+  std::vector<entt::id_type> follows;
+  std::vector<hitbox> hitboxes;
+  std::vector<uint32_t> counts;
+
   lua_pushnil(L);
   while (lua_next(L, -2) != 0) {
     if (!lua_isstring(L, -2)) {
@@ -126,10 +337,12 @@ atlas::atlas(std::string_view name) {
     lua_pop(L, 1);
 
     animation anim{};
+    anim.id = entry_id;
+    anim.offset = static_cast<uint32_t>(_sprites.size());
+    entt::id_type follow{};
 
     if (is_animation) {
       const auto frame_count = static_cast<uint32_t>(lua_objlen(L, -1));
-      anim.keyframes.reserve(frame_count);
 
       for (uint32_t i = 1; i <= frame_count; ++i) {
         lua_rawgeti(L, -1, static_cast<int>(i));
@@ -138,20 +351,19 @@ atlas::atlas(std::string_view name) {
         const auto fields = static_cast<uint32_t>(lua_objlen(L, -1));
         assert(fields >= 5 && "animation frame must have at least x, y, w, h, duration");
 
-        const auto duration_field = static_cast<int>(fields);
-        auto s = parse_sprite(fw, fh, fields - 1);
+        _sprites.push_back(parse_sprite(fw, fh));
+        counts.push_back(parse_hitboxes(name, fields - 1, hitboxes));
 
-        lua_rawgeti(L, -1, duration_field);
-        const auto duration = static_cast<uint32_t>(lua_tonumber(L, -1));
+        lua_rawgeti(L, -1, static_cast<int>(fields));
+        _durations.push_back(static_cast<uint32_t>(lua_tonumber(L, -1)));
         lua_pop(L, 1);
 
-        anim.keyframes.push_back({s, duration});
         lua_pop(L, 1);
       }
 
       lua_getfield(L, -1, "next");
       if (lua_isstring(L, -1))
-        anim.next = hash(lua_tostring(L, -1));
+        follow = hash(lua_tostring(L, -1));
       lua_pop(L, 1);
 
       lua_getfield(L, -1, "once");
@@ -163,26 +375,170 @@ atlas::atlas(std::string_view name) {
       const auto fields = static_cast<uint32_t>(lua_objlen(L, -1));
       assert(fields >= 4 && "sprite must have at least x, y, w, h");
 
-      auto s = parse_sprite(fw, fh, fields);
-      anim.keyframes.push_back({s, 0});
+      _sprites.push_back(parse_sprite(fw, fh));
+      counts.push_back(parse_hitboxes(name, fields, hitboxes));
+      _durations.push_back(0);
     }
 
-    _entries.emplace(entry_id, std::move(anim));
+    anim.count = static_cast<uint32_t>(_sprites.size()) - anim.offset;
+
+    _lookup.emplace(entry_id, static_cast<uint32_t>(_animations.size()));
+    _animations.push_back(std::move(anim));
+    follows.push_back(follow);
     lua_pop(L, 1);
   }
 
   lua_pop(L, 1);
+
+  for (auto i = 0uz; i < _animations.size(); ++i) {
+    if (follows[i] == 0) continue;
+
+    _animations[i].next = resolve(follows[i]);
+    assert(_animations[i].next != none && "animation next entry not found in atlas");
+  }
+
+  // Hitboxes were appended in keyframe order, so each keyframe's run starts where the previous one ended.
+  std::vector<uint32_t> firsts(counts.size());
+  std::exclusive_scan(counts.begin(), counts.end(), firsts.begin(), 0u);
+
+  trace(hitboxes, firsts, counts);
 }
 
-const atlas::animation* atlas::find(entt::id_type entry) const {
-  const auto it = _entries.find(entry);
-  if (it == _entries.end()) return nullptr;
-  return &it->second;
+// Turns each keyframe's hitboxes into Box2D polygons centred on the sprite, so a body placed at the
+// object's position needs no offset; keyframes that end up with the same polygons share an outline.
+void atlas::trace(std::span<const hitbox> boxes, std::span<const uint32_t> firsts, std::span<const uint32_t> counts) {
+  assert(firsts.size() == _sprites.size() && counts.size() == _sprites.size() && "every keyframe needs a hitbox range");
+
+  std::map<std::vector<float>, uint32_t> seen;
+  std::vector<float> key;
+
+  _outlines.assign(_sprites.size(), none);
+
+  for (auto k = 0uz; k < _sprites.size(); ++k) {
+    assert(counts[k] <= capacity && "keyframe has too many hitboxes");
+
+    const auto& s = _sprites[k];
+    key.clear();
+
+    for (const auto& b : boxes.subspan(firsts[k], counts[k])) {
+      if (b.hw <= 0 || b.hh <= 0) continue;
+
+      key.push_back(-s.w * .5f + b.hx + b.hw * .5f);
+      key.push_back(-s.h * .5f + b.hy + b.hh * .5f);
+      key.push_back(b.hw * .5f);
+      key.push_back(b.hh * .5f);
+    }
+
+    if (key.empty()) continue;
+
+    const auto [it, inserted] = seen.try_emplace(key, static_cast<uint32_t>(_ranges.size()));
+    _outlines[k] = it->second;
+    if (!inserted) continue;
+
+    const auto offset = static_cast<uint32_t>(_polygons.size());
+    for (auto i = 0uz; i < key.size(); i += 4) {
+      _polygons.push_back(b2MakeOffsetBox(key[i + 2], key[i + 3], {key[i], key[i + 1]}, b2Rot_identity));
+    }
+
+    _ranges.emplace_back(offset, static_cast<uint32_t>(_polygons.size()) - offset);
+  }
 }
 
-const atlas::keyframe& atlas::keyframe_at(entt::id_type entry, uint32_t frame) const {
-  const auto it = _entries.find(entry);
-  assert(it != _entries.end() && "entry not found in atlas");
-  assert(frame < it->second.keyframes.size() && "frame index out of bounds");
-  return it->second.keyframes[frame];
+void atlas::upload(const pixmap& image) {
+  assert(image.width() == _width && image.height() == _height && "atlas png changed size");
+
+  const auto tw = static_cast<int>(_width);
+  const auto th = static_cast<int>(_height);
+
+  [[maybe_unused]] const auto maximum = static_cast<int>(SDL_GetNumberProperty(
+    SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0));
+  assert(tw <= maximum && "texture width exceeds GPU maximum texture size");
+  assert(th <= maximum && "texture height exceeds GPU maximum texture size");
+
+  _texture = std::unique_ptr<SDL_Texture, SDL_Deleter>(
+    SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, tw, th));
+
+  SDL_UpdateTexture(_texture.get(), nullptr, image.data(), tw * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_RGBA32));
+  SDL_SetTextureScaleMode(_texture.get(), SDL_SCALEMODE_NEAREST);
+  SDL_SetTextureBlendMode(_texture.get(), SDL_BLENDMODE_BLEND);
+}
+
+void atlas::evict() noexcept {
+  _texture.reset();
+  _scaled.clear();
+}
+
+bool atlas::resident() const noexcept {
+  return _texture != nullptr;
+}
+
+size_t atlas::bytes() const noexcept {
+  return static_cast<size_t>(_width) * _height * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_RGBA32);
+}
+
+uint32_t atlas::resolve(entt::id_type entry) const {
+  const auto it = _lookup.find(entry);
+  if (it == _lookup.end()) return none;
+  return it->second;
+}
+
+const atlas::animation& atlas::at(uint32_t index) const noexcept {
+  assert(index < _animations.size() && "animation index out of bounds");
+  return _animations[index];
+}
+
+uint32_t atlas::keyframe(uint32_t index, uint32_t frame) const noexcept {
+  const auto& anim = at(index);
+  assert(frame < anim.count && "frame index out of bounds");
+  return anim.offset + frame;
+}
+
+std::span<const atlas::sprite> atlas::sprites() const noexcept {
+  return _sprites;
+}
+
+std::span<const uint32_t> atlas::durations() const noexcept {
+  return _durations;
+}
+
+uint32_t atlas::outline(uint32_t keyframe) const noexcept {
+  assert(keyframe < _outlines.size() && "keyframe index out of bounds");
+  return _outlines[keyframe];
+}
+
+// Scaled copies are made once per outline and scale step, then reused by every object at that scale.
+// Scales snap to 1/256 steps, and the cache starts over once full, so a tweened scale cannot grow it
+// without bound; the returned span is only valid until the next call.
+std::span<const b2Polygon> atlas::polygons(uint32_t outline, float factor) {
+  assert(outline < _ranges.size() && "outline index out of bounds");
+
+  const auto [offset, count] = _ranges[outline];
+  const std::span<const b2Polygon> base{_polygons.data() + offset, count};
+
+  const auto step = std::max<int32_t>(1, static_cast<int32_t>(std::lround(factor * static_cast<float>(steps))));
+  if (step == steps) [[likely]] return base;
+
+  const auto key = static_cast<uint64_t>(outline) << 32 | static_cast<uint32_t>(step);
+  if (_scaled.size() >= cached && !_scaled.contains(key)) [[unlikely]] _scaled.clear();
+
+  auto [it, inserted] = _scaled.try_emplace(key);
+  if (inserted) {
+    const auto snapped = static_cast<float>(step) / static_cast<float>(steps);
+    it->second.reserve(count);
+    for (const auto& p : base) it->second.push_back(scale(p, snapped));
+  }
+
+  return it->second;
+}
+
+// Bounds of the whole outline around the body origin.
+b2AABB atlas::bounds(uint32_t outline, float factor) {
+  b2AABB result{{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+                {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()}};
+
+  for (const auto& p : polygons(outline, factor)) {
+    result = b2AABB_Union(result, b2ComputePolygonAABB(&p, b2Transform_identity));
+  }
+
+  return result;
 }
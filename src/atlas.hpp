@@ -4,23 +4,30 @@
 
 class atlasregistry;
 class compositor;
+class pixmap;
 
 class atlas final {
 public:
   struct alignas(8) sprite final {
     float u0, v0, u1, v1;
     float w, h;
-    float hx{}, hy{}, hw{}, hh{};
   };
 
-  struct keyframe final {
-    sprite sprite;
-    uint32_t duration{};
+  struct hitbox final {
+    float hx{}, hy{}, hw{}, hh{};
   };
 
+  static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+  // Most hitboxes a keyframe may carry.
+  static constexpr uint32_t capacity = 4;
+
+  // Keyframes of all animations live contiguously in the atlas; an animation is a span into them.
   struct animation final {
-    std::vector<keyframe> keyframes;
-    entt::id_type next{};
+    entt::id_type id{};
+    uint32_t offset{};
+    uint32_t count{};
+    uint32_t next{none};
     bool once{};
   };
 
@@ -31,14 +38,51 @@ public:
   atlas(atlas&&) noexcept = default;
   atlas& operator=(atlas&&) noexcept = default;
 
-  const animation* find(entt::id_type entry) const;
-  const keyframe& keyframe_at(entt::id_type entry, uint32_t frame) const;
+  [[nodiscard]] static pixmap decode(std::string_view name);
+
+  void upload(const pixmap& image);
+  void evict() noexcept;
+
+  [[nodiscard]] bool resident() const noexcept;
+  [[nodiscard]] size_t bytes() const noexcept;
+
+  [[nodiscard]] uint32_t resolve(entt::id_type entry) const;
+
+  const animation& at(uint32_t index) const noexcept;
+  [[nodiscard]] uint32_t keyframe(uint32_t index, uint32_t frame) const noexcept;
+
+  [[nodiscard]] std::span<const sprite> sprites() const noexcept;
+  [[nodiscard]] std::span<const uint32_t> durations() const noexcept;
+
+  // Keyframes with the same hitboxes and sprite size share one outline; none when a keyframe has no hitbox.
+  [[nodiscard]] uint32_t outline(uint32_t keyframe) const noexcept;
+  [[nodiscard]] std::span<const b2Polygon> polygons(uint32_t outline, float scale);
+  [[nodiscard]] b2AABB bounds(uint32_t outline, float scale);
 
 private:
+  void index(std::span<const uint8_t> buffer);
+  void script(std::string_view name);
+  void trace(std::span<const hitbox> boxes, std::span<const uint32_t> firsts, std::span<const uint32_t> counts);
+
+  // Scale resolution of the cached polygon copies, and how many copies are kept at most.
+  static constexpr int32_t steps = 256;
+  static constexpr size_t cached = 256;
+
   friend class ::atlasregistry;
   friend class ::compositor;
 
+  std::string _name;
+  uint32_t _width{};
+  uint32_t _height{};
+  uint32_t _references{};
+  uint64_t _stamp{};
   std::unique_ptr<SDL_Texture, SDL_Deleter> _texture;
-  std::unordered_map<entt::id_type, animation> _entries;
-  std::vector<SDL_Vertex> _vertices;
+  std::vector<animation> _animations;
+  std::vector<sprite> _sprites;
+  std::vector<uint32_t> _durations;
+  std::vector<uint32_t> _outlines;
+  std::vector<std::pair<uint32_t, uint32_t>> _ranges;
+  std::vector<b2Polygon> _polygons;
+  std::unordered_map<uint64_t, std::vector<b2Polygon>> _scaled;
+  std::unordered_map<entt::id_type, uint32_t> _lookup;
 };
@@ -1,24 +1,146 @@
 #include "atlasregistry.hpp"
 
-atlasregistry::atlasregistry() {
+namespace {
+  // Reads and decodes the named atlas images across worker threads; textures are created later on the render thread.
+  std::vector<std::optional<pixmap>> decode(const std::vector<std::string_view>& names) {
+    std::vector<std::optional<pixmap>> images(names.size());
+
+#ifdef EMSCRIPTEN
+    for (auto i = 0uz; i < names.size(); ++i) {
+      images[i].emplace(atlas::decode(names[i]));
+    }
+#else
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex mutex;
+
+    const auto work = [&] {
+      for (auto i = next.fetch_add(1); i < names.size(); i = next.fetch_add(1)) {
+        try {
+          images[i].emplace(atlas::decode(names[i]));
+        } catch (...) {
+          const std::lock_guard lock(mutex);
+          if (!failure) failure = std::current_exception();
+        }
+      }
+    };
+
+    const auto count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), names.size());
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (auto i = 0uz; i < count; ++i) {
+      workers.emplace_back(work);
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    if (failure) std::rethrow_exception(failure);
+#endif
+
+    return images;
+  }
+}
+
+atlasregistry::atlasregistry(size_t budget)
+    : _budget(budget) {
   const auto entries = io::enumerate("blobs/atlas");
 
   for (const auto& filename : entries) {
     if (!filename.ends_with(".png")) continue;
     auto name = std::filesystem::path{filename}.stem().string();
     const auto id = entt::hashed_string::value(name.c_str(), name.size());
-    _atlases.emplace(id, atlas{name});
+    _lookup.emplace(id, static_cast<uint32_t>(_atlases.size()));
+    _atlases.emplace_back(name);
   }
 }
 
-atlas& atlasregistry::get(atlas_id id) {
-  const auto it = _atlases.find(id);
-  assert(it != _atlases.end() && "atlas not found");
+uint32_t atlasregistry::resolve(atlas_id id) const {
+  const auto it = _lookup.find(id);
+  assert(it != _lookup.end() && "atlas not found");
   return it->second;
 }
 
-const atlas& atlasregistry::get(atlas_id id) const {
-  const auto it = _atlases.find(id);
-  assert(it != _atlases.end() && "atlas not found");
-  return it->second;
+atlas& atlasregistry::at(uint32_t index) noexcept {
+  assert(index < _atlases.size() && "atlas index out of bounds");
+  return _atlases[index];
+}
+
+const atlas& atlasregistry::at(uint32_t index) const noexcept {
+  assert(index < _atlases.size() && "atlas index out of bounds");
+  return _atlases[index];
+}
+
+void atlasregistry::acquire(std::span<const uint32_t> indices) {
+  std::vector<atlas*> missing;
+
+  for (const auto index : indices) {
+    auto& a = at(index);
+    if (a._references++ == 0) std::erase(_unreferenced, &a);
+    if (!a.resident()) missing.push_back(&a);
+  }
+
+  load(missing);
+  trim();
+}
+
+void atlasregistry::release(std::span<const uint32_t> indices) {
+  for (const auto index : indices) {
+    auto& a = at(index);
+    assert(a._references > 0 && "atlas released more often than acquired");
+    if (--a._references == 0 && a.resident()) _unreferenced.push_back(&a);
+  }
+
+  trim();
+}
+
+void atlasregistry::require(atlas& a) {
+  a._stamp = _frame;
+  if (a.resident()) [[likely]] return;
+
+  atlas* const missing[] = {&a};
+  load(missing);
+
+  if (a._references == 0) _unreferenced.push_back(&a);
+}
+
+void atlasregistry::load(std::span<atlas* const> atlases) {
+  if (atlases.empty()) return;
+
+  std::vector<std::string_view> names;
+  names.reserve(atlases.size());
+  for (const auto* a : atlases) {
+    names.emplace_back(a->_name);
+  }
+
+  const auto images = decode(names);
+
+  for (auto i = 0uz; i < atlases.size(); ++i) {
+    atlases[i]->upload(*images[i]);
+    _resident += atlases[i]->bytes();
+  }
+}
+
+void atlasregistry::sweep() {
+  trim();
+  ++_frame;
+}
+
+// Evicts unreferenced atlases, least recently required first, until the resident set fits the budget.
+// Only runs between frames, never while batches may still hold an atlas texture, and never evicts an
+// atlas required during the current frame, which would only be decoded again on the next one.
+void atlasregistry::trim() {
+  if (_resident <= _budget) return;
+
+  std::ranges::stable_sort(_unreferenced, {}, [](const atlas* a) { return a->_stamp; });
+
+  auto it = _unreferenced.begin();
+  while (_resident > _budget && it != _unreferenced.end() && (*it)->_stamp != _frame) {
+    _resident -= (*it)->bytes();
+    (*it)->evict();
+    ++it;
+  }
+
+  _unreferenced.erase(_unreferenced.begin(), it);
 }
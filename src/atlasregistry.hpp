@@ -2,20 +2,35 @@
 
 #include "common.hpp"
 
-class compositor;
-
 using atlas_id = entt::id_type;
 
 class atlasregistry final {
 public:
-  atlasregistry();
+  explicit atlasregistry(size_t budget);
   ~atlasregistry() = default;
 
-  atlas& get(atlas_id id);
-  const atlas& get(atlas_id id) const;
+  [[nodiscard]] uint32_t resolve(atlas_id id) const;
+
+  atlas& at(uint32_t index) noexcept;
+  const atlas& at(uint32_t index) const noexcept;
+
+  void acquire(std::span<const uint32_t> indices);
+  void release(std::span<const uint32_t> indices);
+
+  // Loads an atlas needed mid-frame and marks it used; eviction waits for sweep, since its texture may already be batched.
+  void require(atlas& atlas);
+
+  // Ends the frame: evicts down to the budget, sparing every atlas required during the frame.
+  void sweep();
 
 private:
-  friend class ::compositor;
+  void load(std::span<class atlas* const> atlases);
+  void trim();
 
-  std::unordered_map<atlas_id, class atlas> _atlases;
+  std::vector<class atlas> _atlases;
+  std::unordered_map<atlas_id, uint32_t> _lookup;
+  std::vector<class atlas*> _unreferenced;
+  size_t _budget;
+  size_t _resident{};
+  uint64_t _frame{1};
 };
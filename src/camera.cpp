@@ -0,0 +1,154 @@
+#include "camera.hpp"
+
+namespace {
+  entt::id_type hash(std::string_view value) {
+    return entt::hashed_string::value(value.data(), value.size());
+  }
+
+  camera& resolve(lua_State* state) {
+    auto* proxy = static_cast<cameraproxy*>(luaL_checkudata(state, 1, "Camera"));
+    return proxy->registry->ctx().get<camera>();
+  }
+
+  int camera_index(lua_State* state) {
+    auto* proxy = static_cast<cameraproxy*>(luaL_checkudata(state, 1, "Camera"));
+    const auto& c = proxy->registry->ctx().get<camera>();
+    const std::string_view key = luaL_checkstring(state, 2);
+
+    if (key == "x") {
+      lua_pushnumber(state, static_cast<double>(c.x));
+      return 1;
+    }
+
+    if (key == "y") {
+      lua_pushnumber(state, static_cast<double>(c.y));
+      return 1;
+    }
+
+    if (key == "zoom") {
+      lua_pushnumber(state, static_cast<double>(c.zoom));
+      return 1;
+    }
+
+    if (key == "follow") {
+      const auto& registry = *proxy->registry;
+      if (!registry.valid(c.target)) return lua_pushnil(state), 1;
+
+      const auto& lu = registry.ctx().get<lookupable>();
+      const auto it = lu.names.find(registry.get<identifiable>(c.target).name);
+      if (it == lu.names.end()) return lua_pushnil(state), 1;
+
+      lua_pushstring(state, it->second.c_str());
+      return 1;
+    }
+
+    return lua_pushnil(state), 1;
+  }
+
+  int camera_newindex(lua_State* state) {
+    auto* proxy = static_cast<cameraproxy*>(luaL_checkudata(state, 1, "Camera"));
+    auto& c = resolve(state);
+    const std::string_view key = luaL_checkstring(state, 2);
+
+    if (key == "x") {
+      c.x = static_cast<float>(luaL_checknumber(state, 3));
+      return 0;
+    }
+
+    if (key == "y") {
+      c.y = static_cast<float>(luaL_checknumber(state, 3));
+      return 0;
+    }
+
+    if (key == "zoom") {
+      const auto zoom = static_cast<float>(luaL_checknumber(state, 3));
+      luaL_argcheck(state, zoom > .0f, 3, "zoom must be positive");
+      c.zoom = zoom;
+      return 0;
+    }
+
+    if (key == "follow") {
+      if (lua_isnoneornil(state, 3)) {
+        c.target = entt::null;
+      } else {
+        c.follow(*proxy->registry, hash(luaL_checkstring(state, 3)));
+      }
+      return 0;
+    }
+
+    if (key == "bounds") {
+      if (lua_isnoneornil(state, 3)) {
+        c.bounds.reset();
+        return 0;
+      }
+
+      luaL_checktype(state, 3, LUA_TTABLE);
+      SDL_FRect b{};
+      float* const fields[] = {&b.x, &b.y, &b.w, &b.h};
+      for (int i = 0; i < 4; ++i) {
+        lua_rawgeti(state, 3, i + 1);
+        *fields[i] = static_cast<float>(luaL_checknumber(state, -1));
+        lua_pop(state, 1);
+      }
+      c.bounds = b;
+      return 0;
+    }
+
+    return 0;
+  }
+
+  void init() {
+    luaL_newmetatable(L, "Camera");
+
+    lua_pushcfunction(L, camera_index);
+    lua_setfield(L, -2, "__index");
+
+    lua_pushcfunction(L, camera_newindex);
+    lua_setfield(L, -2, "__newindex");
+
+    lua_pop(L, 1);
+  }
+}
+
+void camera::follow(const entt::registry& registry, entt::id_type name) noexcept {
+  target = entt::null;
+
+  for (auto&& [entity, id] : registry.view<identifiable>().each()) {
+    if (id.name != name) continue;
+
+    target = entity;
+    return;
+  }
+}
+
+// Centres the followed object, then keeps the view inside the bounds; a view wider than the bounds is centred on them.
+void camera::update(const entt::registry& registry) noexcept {
+  const auto width = viewport.width / zoom;
+  const auto height = viewport.height / zoom;
+
+  if (registry.valid(target)) {
+    if (const auto* t = registry.try_get<transform>(target)) {
+      x = t->x - width * .5f;
+      y = t->y - height * .5f;
+    }
+  }
+
+  if (!bounds) return;
+
+  const auto& b = *bounds;
+  x = width >= b.w ? b.x + (b.w - width) * .5f : std::clamp(x, b.x, b.x + b.w - width);
+  y = height >= b.h ? b.y + (b.h - height) * .5f : std::clamp(y, b.y, b.y + b.h - height);
+}
+
+projection camera::project(float parallax) const noexcept {
+  return {x * parallax, y * parallax, zoom};
+}
+
+SDL_FRect camera::visible(float parallax) const noexcept {
+  return {x * parallax, y * parallax, viewport.width / zoom, viewport.height / zoom};
+}
+
+void camera::wire() {
+  static std::once_flag once;
+  std::call_once(once, init);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "common.hpp"
+
+// Maps world coordinates to the screen: screen = (world - origin) * zoom.
+struct projection final {
+  float x{};
+  float y{};
+  float zoom{1.0f};
+
+  [[nodiscard]] float sx(float wx) const noexcept { return (wx - x) * zoom; }
+  [[nodiscard]] float sy(float wy) const noexcept { return (wy - y) * zoom; }
+};
+
+// x and y are the world position of the top-left corner of the screen.
+struct camera final {
+  float x{};
+  float y{};
+  float zoom{1.0f};
+  std::optional<SDL_FRect> bounds;
+  entt::entity target{entt::null};
+
+  void follow(const entt::registry& registry, entt::id_type name) noexcept;
+  void update(const entt::registry& registry) noexcept;
+
+  [[nodiscard]] projection project(float parallax) const noexcept;
+  // The world rectangle on screen for content at the given parallax, the same one project(parallax) maps.
+  [[nodiscard]] SDL_FRect visible(float parallax = 1.0f) const noexcept;
+
+  static void wire();
+};
+
+struct cameraproxy final {
+  entt::registry* registry;
+};
@@ -2,9 +2,51 @@
 
 #include "common.hpp"
 
+// How a cartridge detects collisions, set by collision in scripts/main.lua: "physics" gives every
+// collidable object a Box2D body, "overlap" tests hitbox bounds directly and never steps the world.
+enum class collision : uint8_t {
+  physics,
+  overlap,
+};
+
+// The body sits at the object's position; its shapes are the current keyframe's outline at the object's scale.
 struct collidable final {
   b2BodyId body{};
-  b2ShapeId shape{};
-  float hx{}, hy{}, hw{}, hh{};
-  float ox{}, oy{};
+  std::array<b2ShapeId, atlas::capacity> shapes{};
+  uint32_t count{};
+  uint32_t outline{atlas::none};
+  float scale{};
+  uint64_t category{B2_DEFAULT_CATEGORY_BITS};
+  uint64_t mask{B2_DEFAULT_MASK_BITS};
+};
+
+// Marks an object that the overlap backend tests; it reads the keyframe outline straight from the atlas.
+struct overlappable final {
+  uint64_t category{B2_DEFAULT_CATEGORY_BITS};
+  uint64_t mask{B2_DEFAULT_MASK_BITS};
+  b2BodyType type{b2_dynamicBody};
+};
+
+// Two objects are tested against each other only when each one's layer is in the other's mask.
+[[nodiscard]] constexpr bool admits(uint64_t category_a, uint64_t mask_a, uint64_t category_b, uint64_t mask_b) noexcept {
+  return (category_a & mask_b) != 0 && (category_b & mask_a) != 0;
+}
+
+// Collision layers named by the stage's object kinds and its tilemap; each gets a category bit the first time it is
+// named, and bit 0 stays with objects that name none.
+struct categories final {
+  std::vector<entt::id_type> names;
+
+  [[nodiscard]] uint64_t bit(entt::id_type name) {
+    auto it = std::ranges::find(names, name);
+    if (it == names.end()) {
+      assert(names.size() < 63 && "too many collision layers");
+      it = names.insert(names.end(), name);
+    }
+
+    return uint64_t{1} << (it - names.begin() + 1);
+  }
 };
+
+// Tags a collidable whose body lags behind its transform or keyframe; object::update syncs and clears it.
+struct displaced final {};
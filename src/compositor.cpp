@@ -1,59 +1,345 @@
 #include "compositor.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
 namespace {
   constexpr size_t quads = 4096;
+  constexpr size_t shorts = 65536 / 4;
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  using lanes = __m128;
+
+  inline lanes set(float a, float b, float c, float d) noexcept { return _mm_setr_ps(a, b, c, d); }
+  inline lanes splat(float value) noexcept { return _mm_set1_ps(value); }
+  inline lanes add(lanes a, lanes b) noexcept { return _mm_add_ps(a, b); }
+  inline lanes sub(lanes a, lanes b) noexcept { return _mm_sub_ps(a, b); }
+  inline lanes mul(lanes a, lanes b) noexcept { return _mm_mul_ps(a, b); }
+  inline void interleave(float* out, lanes x, lanes y) noexcept {
+    _mm_storeu_ps(out, _mm_unpacklo_ps(x, y));
+    _mm_storeu_ps(out + 4, _mm_unpackhi_ps(x, y));
+  }
+#elif defined(__ARM_NEON)
+  using lanes = float32x4_t;
+
+  inline lanes set(float a, float b, float c, float d) noexcept {
+    alignas(16) const float values[4]{a, b, c, d};
+    return vld1q_f32(values);
+  }
+  inline lanes splat(float value) noexcept { return vdupq_n_f32(value); }
+  inline lanes add(lanes a, lanes b) noexcept { return vaddq_f32(a, b); }
+  inline lanes sub(lanes a, lanes b) noexcept { return vsubq_f32(a, b); }
+  inline lanes mul(lanes a, lanes b) noexcept { return vmulq_f32(a, b); }
+  inline void interleave(float* out, lanes x, lanes y) noexcept { vst2q_f32(out, (float32x4x2_t{{x, y}})); }
+#elif defined(__wasm_simd128__)
+  using lanes = v128_t;
+
+  inline lanes set(float a, float b, float c, float d) noexcept { return wasm_f32x4_make(a, b, c, d); }
+  inline lanes splat(float value) noexcept { return wasm_f32x4_splat(value); }
+  inline lanes add(lanes a, lanes b) noexcept { return wasm_f32x4_add(a, b); }
+  inline lanes sub(lanes a, lanes b) noexcept { return wasm_f32x4_sub(a, b); }
+  inline lanes mul(lanes a, lanes b) noexcept { return wasm_f32x4_mul(a, b); }
+  inline void interleave(float* out, lanes x, lanes y) noexcept {
+    wasm_v128_store(out, wasm_i32x4_shuffle(x, y, 0, 4, 1, 5));
+    wasm_v128_store(out + 4, wasm_i32x4_shuffle(x, y, 2, 6, 3, 7));
+  }
+#else
+  struct lanes final {
+    float v[4];
+  };
+
+  inline lanes set(float a, float b, float c, float d) noexcept { return {{a, b, c, d}}; }
+  inline lanes splat(float value) noexcept { return {{value, value, value, value}}; }
+  inline lanes add(lanes a, lanes b) noexcept { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+  inline lanes sub(lanes a, lanes b) noexcept { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+  inline lanes mul(lanes a, lanes b) noexcept { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+  inline void interleave(float* out, lanes x, lanes y) noexcept {
+    for (auto i = 0uz; i < 4; ++i) {
+      out[i * 2] = x.v[i];
+      out[i * 2 + 1] = y.v[i];
+    }
+  }
+#endif
+
+  // Positions are written interleaved, x0 y0 x1 y1 x2 y2 x3 y3, straight into the xy stream.
+  // Corners run top-left, top-right, bottom-right, bottom-left, matching the index pattern.
+  inline void translate(float* out, const atlas::sprite& sprite, float x, float y) noexcept {
+    const auto hw = sprite.w * .5f;
+    const auto hh = sprite.h * .5f;
+
+    interleave(out,
+      add(set(-hw, +hw, +hw, -hw), splat(x)),
+      add(set(-hh, -hh, +hh, +hh), splat(y)));
+  }
+
+  inline void stretch(float* out, const atlas::sprite& sprite, float x, float y, float scale) noexcept {
+    const auto hw = sprite.w * scale * .5f;
+    const auto hh = sprite.h * scale * .5f;
+
+    interleave(out,
+      add(set(-hw, +hw, +hw, -hw), splat(x)),
+      add(set(-hh, -hh, +hh, +hh), splat(y)));
+  }
+
+  inline void rotate(float* out, const atlas::sprite& sprite, float x, float y, float scale, float cosr, float sinr) noexcept {
+    const auto hw = sprite.w * scale * .5f;
+    const auto hh = sprite.h * scale * .5f;
+
+    const auto cx = set(-hw, +hw, +hw, -hw);
+    const auto cy = set(-hh, -hh, +hh, +hh);
+    const auto c = splat(cosr);
+    const auto s = splat(sinr);
+
+    interleave(out,
+      add(sub(mul(cx, c), mul(cy, s)), splat(x)),
+      add(add(mul(cx, s), mul(cy, c)), splat(y)));
+  }
+
+  inline void map(SDL_FPoint* uv, const atlas::sprite& sprite) noexcept {
+    uv[0] = {sprite.u0, sprite.v0};
+    uv[1] = {sprite.u1, sprite.v0};
+    uv[2] = {sprite.u1, sprite.v1};
+    uv[3] = {sprite.u0, sprite.v1};
+  }
+
+  inline SDL_FColor tint(uint8_t alpha) noexcept {
+    return {1.0f, 1.0f, 1.0f, static_cast<float>(alpha) / 255.0f};
+  }
+}
+
+void compositor::bulk::push(const atlas::sprite& sprite, float x, float y, float scale, float cosr, float sinr, uint8_t alpha) {
+  sprites.push_back(&sprite);
+  xs.push_back(x);
+  ys.push_back(y);
+  scales.push_back(scale);
+  cosines.push_back(cosr);
+  sines.push_back(sinr);
+  alphas.push_back(alpha);
+}
+
+void compositor::bulk::clear() noexcept {
+  sprites.clear();
+  xs.clear();
+  ys.clear();
+  scales.clear();
+  cosines.clear();
+  sines.clear();
+  alphas.clear();
+}
+
+size_t compositor::bulk::size() const noexcept {
+  return sprites.size();
+}
+
+compositor::compositor() {
+  _positions.reserve(quads * 4);
+  _uvs.reserve(quads * 4);
+  grow(quads);
+}
+
+void compositor::grow(size_t count) {
+  const auto narrow = std::min(count, shorts);
+  const auto existing16 = _indices16.size() / 6;
+  if (narrow > existing16) {
+    const auto target = std::min(std::max(narrow, existing16 * 2), shorts);
+    _indices16.resize(target * 6);
+    fill(_indices16.data(), existing16, target);
+  }
+
+  if (count <= shorts) [[likely]] return;
+
+  const auto existing32 = _indices32.size() / 6;
+  if (count <= existing32) return;
+
+  const auto target = std::max(count, existing32 * 2);
+  _indices32.resize(target * 6);
+  fill(_indices32.data(), existing32, target);
 }
 
-compositor::compositor(atlasregistry& registry)
-  : _registry(registry) {
+template <typename T>
+void compositor::fill(T* indices, size_t from, size_t to) noexcept {
+  for (auto q = from; q < to; ++q) {
+    const auto base = static_cast<T>(q * 4);
+    auto* const i = indices + q * 6;
+    i[0] = base;
+    i[1] = static_cast<T>(base + 1);
+    i[2] = static_cast<T>(base + 2);
+    i[3] = base;
+    i[4] = static_cast<T>(base + 2);
+    i[5] = static_cast<T>(base + 3);
+  }
+}
 
-  _indices.resize(quads * 6);
+size_t compositor::reserve(SDL_Texture* texture, size_t count) {
+  const auto size = _positions.size();
 
-  for (auto q = 0uz; q < quads; ++q) {
-    const auto base = static_cast<int>(q * 4);
-    const auto i = q * 6;
-    _indices[i + 0] = base;
-    _indices[i + 1] = base + 1;
-    _indices[i + 2] = base + 2;
-    _indices[i + 3] = base;
-    _indices[i + 4] = base + 2;
-    _indices[i + 5] = base + 3;
+  if (_batches.empty() || _batches.back().texture != texture) {
+    _batches.push_back({texture, static_cast<uint32_t>(size), 0, {}, 255, false});
   }
+
+  _batches.back().count += static_cast<uint32_t>(count * 4);
+  _counting.drawn += static_cast<uint32_t>(count);
+
+  _positions.resize(size + count * 4);
+  _uvs.resize(size + count * 4);
+  return size;
+}
+
+void compositor::paint(size_t index, uint8_t alpha) {
+  auto& b = _batches.back();
+
+  if (!b.blended) [[likely]] {
+    if (index == b.offset) b.alpha = alpha;
+    if (alpha == b.alpha) [[likely]] return;
+
+    b.blended = true;
+    _colors.resize(index);
+    std::fill(_colors.begin() + b.offset, _colors.end(), tint(b.alpha));
+  }
+
+  _colors.resize(index + 4, tint(alpha));
 }
 
 void compositor::push(atlas& a, const atlas::sprite& sprite, float x, float y, float scale, float cosr, float sinr, uint8_t alpha) {
-  const auto hw = sprite.w * scale * 0.5f;
-  const auto hh = sprite.h * scale * 0.5f;
-  const auto color = SDL_FColor{1.0f, 1.0f, 1.0f, static_cast<float>(alpha) / 255.0f};
+  const auto index = reserve(a._texture.get(), 1);
+
+  rotate(&_positions[index].x, sprite, x, y, scale, cosr, sinr);
+  map(&_uvs[index], sprite);
+  paint(index, alpha);
+}
 
-  const auto size = a._vertices.size();
-  assert(size / 4 < quads && "quad limit exceeded");
+void compositor::submit(atlas& a, const bulk& b) {
+  const auto n = b.size();
+  if (n == 0) [[unlikely]] return;
 
-  a._vertices.resize(size + 4);
-  auto* v = a._vertices.data() + size;
+  auto index = reserve(a._texture.get(), n);
 
-  v[0] = {{-hw * cosr + hh * sinr + x, -hw * sinr - hh * cosr + y}, color, {sprite.u0, sprite.v0}};
-  v[1] = {{+hw * cosr + hh * sinr + x, +hw * sinr - hh * cosr + y}, color, {sprite.u1, sprite.v0}};
-  v[2] = {{+hw * cosr - hh * sinr + x, +hw * sinr + hh * cosr + y}, color, {sprite.u1, sprite.v1}};
-  v[3] = {{-hw * cosr - hh * sinr + x, -hw * sinr + hh * cosr + y}, color, {sprite.u0, sprite.v1}};
+  for (auto i = 0uz; i < n; ++i, index += 4) {
+    const auto& sprite = *b.sprites[i];
+
+    if (b.scales[i] == 1.0f && b.sines[i] == .0f && b.cosines[i] == 1.0f) [[likely]] {
+      translate(&_positions[index].x, sprite, b.xs[i], b.ys[i]);
+    } else {
+      rotate(&_positions[index].x, sprite, b.xs[i], b.ys[i], b.scales[i], b.cosines[i], b.sines[i]);
+    }
+
+    map(&_uvs[index], sprite);
+    paint(index, b.alphas[i]);
+  }
 }
 
-void compositor::draw() {
-  for (auto& [id, a] : _registry._atlases) {
-    if (a._vertices.empty()) continue;
+compositor::bulk& compositor::staging() noexcept {
+  return _staging;
+}
 
-    const auto count = static_cast<int>(a._vertices.size());
-    assert(count % 4 == 0 && "vertex count must be a multiple of 4");
+// Appends prebuilt world-space quads through the projection, for geometry that is assembled once and drawn every frame.
+void compositor::mesh(atlas& a, std::span<const SDL_FPoint> positions, std::span<const SDL_FPoint> uvs, const projection& p, uint8_t alpha) {
+  assert(positions.size() == uvs.size() && positions.size() % 4 == 0 && "mesh must be made of whole quads");
 
-    SDL_RenderGeometry(
+  const auto n = positions.size() / 4;
+  if (n == 0) [[unlikely]] return;
+
+  const auto index = reserve(a._texture.get(), n);
+  std::ranges::copy(uvs, _uvs.begin() + static_cast<std::ptrdiff_t>(index));
+
+  auto* out = &_positions[index];
+  for (auto i = 0uz; i < positions.size(); ++i) {
+    out[i] = {p.sx(positions[i].x), p.sy(positions[i].y)};
+  }
+
+  for (auto i = 0uz; i < n; ++i) {
+    paint(index + i * 4, alpha);
+  }
+}
+
+// Draws one sprite many times, unrotated, straight from structure-of-arrays particle storage.
+void compositor::scatter(atlas& a, const atlas::sprite& sprite, std::span<const float> xs, std::span<const float> ys, std::span<const float> scales, std::span<const uint8_t> alphas, const projection& p) {
+  const auto n = xs.size();
+  if (n == 0) [[unlikely]] return;
+
+  auto index = reserve(a._texture.get(), n);
+
+  for (auto i = 0uz; i < n; ++i, index += 4) {
+    stretch(&_positions[index].x, sprite, p.sx(xs[i]), p.sy(ys[i]), scales[i] * p.zoom);
+    map(&_uvs[index], sprite);
+    paint(index, alphas[i]);
+  }
+}
+
+void compositor::blit(SDL_Texture* texture, const SDL_FRect& destination) {
+  const auto index = reserve(texture, 1);
+
+  const auto x0 = destination.x;
+  const auto y0 = destination.y;
+  const auto x1 = destination.x + destination.w;
+  const auto y1 = destination.y + destination.h;
+
+  auto* p = &_positions[index];
+  p[0] = {x0, y0};
+  p[1] = {x1, y0};
+  p[2] = {x1, y1};
+  p[3] = {x0, y1};
+
+  auto* uv = &_uvs[index];
+  uv[0] = {.0f, .0f};
+  uv[1] = {1.0f, .0f};
+  uv[2] = {1.0f, 1.0f};
+  uv[3] = {.0f, 1.0f};
+
+  paint(index, 255);
+}
+
+void compositor::flush() {
+  for (auto& b : _batches) {
+    const auto count = static_cast<size_t>(b.count / 4);
+    grow(count);
+
+    const auto narrow = count <= shorts;
+    const void* indices = narrow
+      ? static_cast<const void*>(_indices16.data())
+      : static_cast<const void*>(_indices32.data());
+
+    b.color = tint(b.alpha);
+
+    SDL_RenderGeometryRaw(
       renderer,
-      a._texture.get(),
-      a._vertices.data(),
-      count,
-      _indices.data(),
-      count / 4 * 6
+      b.texture,
+      &_positions[b.offset].x,
+      static_cast<int>(sizeof(SDL_FPoint)),
+      b.blended ? &_colors[b.offset] : &b.color,
+      b.blended ? static_cast<int>(sizeof(SDL_FColor)) : 0,
+      &_uvs[b.offset].x,
+      static_cast<int>(sizeof(SDL_FPoint)),
+      static_cast<int>(b.count),
+      indices,
+      static_cast<int>(count * 6),
+      narrow ? 2 : 4
     );
-
-    a._vertices.clear();
   }
+
+  _counting.batches += static_cast<uint32_t>(_batches.size());
+
+  _positions.clear();
+  _uvs.clear();
+  _colors.clear();
+  _batches.clear();
+}
+
+void compositor::draw() {
+  flush();
+
+  _statistics = std::exchange(_counting, {});
+}
+
+void compositor::cull(uint32_t count) noexcept {
+  _counting.culled += count;
+}
+
+const compositor::statistics& compositor::stats() const noexcept {
+  return _statistics;
 }
@@ -4,14 +4,76 @@
 
 class compositor final {
 public:
-  explicit compositor(atlasregistry& registry);
+  struct statistics final {
+    uint32_t drawn{};
+    uint32_t culled{};
+    uint32_t batches{};
+  };
+
+  struct bulk final {
+    std::vector<const atlas::sprite*> sprites;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> scales;
+    std::vector<float> cosines;
+    std::vector<float> sines;
+    std::vector<uint8_t> alphas;
+
+    void push(const atlas::sprite& sprite, float x, float y, float scale, float cosr, float sinr, uint8_t alpha);
+    void clear() noexcept;
+    size_t size() const noexcept;
+  };
+
+  compositor();
   ~compositor() = default;
 
   void push(atlas& atlas, const atlas::sprite& sprite, float x, float y, float scale, float cosr, float sinr, uint8_t alpha);
 
+  void submit(atlas& atlas, const bulk& b);
+
+  // Scratch bulk reused by every caller that gathers sprites before submitting, so it stops allocating once warm.
+  bulk& staging() noexcept;
+
+  void mesh(atlas& atlas, std::span<const SDL_FPoint> positions, std::span<const SDL_FPoint> uvs, const projection& p, uint8_t alpha);
+
+  void scatter(atlas& atlas, const atlas::sprite& sprite, std::span<const float> xs, std::span<const float> ys, std::span<const float> scales, std::span<const uint8_t> alphas, const projection& p);
+
+  void blit(SDL_Texture* texture, const SDL_FRect& destination);
+
+  void cull(uint32_t count) noexcept;
+
+  void flush();
+
   void draw();
 
+  const statistics& stats() const noexcept;
+
 private:
-  atlasregistry& _registry;
-  std::vector<int> _indices;
+  struct batch final {
+    SDL_Texture* texture;
+    uint32_t offset;
+    uint32_t count;
+    SDL_FColor color;
+    uint8_t alpha;
+    bool blended;
+  };
+
+  void grow(size_t count);
+
+  template <typename T>
+  static void fill(T* indices, size_t from, size_t to) noexcept;
+
+  size_t reserve(SDL_Texture* texture, size_t count);
+
+  void paint(size_t index, uint8_t alpha);
+
+  std::vector<SDL_FPoint> _positions;
+  std::vector<SDL_FPoint> _uvs;
+  std::vector<SDL_FColor> _colors;
+  std::vector<batch> _batches;
+  std::vector<uint16_t> _indices16;
+  std::vector<int32_t> _indices32;
+  bulk _staging;
+  statistics _counting{};
+  statistics _statistics{};
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common.hpp"
+
+// Emitter definition and its live particles; particles are kept as parallel arrays, compacted on death.
+struct emissive final {
+  uint32_t atlas{};
+  uint32_t keyframe{};
+  float x{};
+  float y{};
+  float rate{};
+  float accumulator{};
+  std::array<float, 2> lifetime{1.0f, 1.0f};
+  std::array<float, 2> speed{};
+  std::array<float, 2> angle{0.0f, 360.0f};
+  std::array<float, 2> gravity{};
+  std::array<float, 2> scale{1.0f, 1.0f};
+  std::array<float, 2> alpha{255.0f, 255.0f};
+  uint32_t limit{1024};
+  bool active{true};
+  std::minstd_rand random;
+
+  std::vector<float> xs;
+  std::vector<float> ys;
+  std::vector<float> vxs;
+  std::vector<float> vys;
+  std::vector<float> ages;
+  std::vector<float> lifetimes;
+  std::vector<float> scales;
+  std::vector<uint8_t> alphas;
+
+  [[nodiscard]] size_t size() const noexcept { return xs.size(); }
+};
+
+struct emitterproxy final {
+  entt::registry* registry;
+  entt::entity entity;
+};
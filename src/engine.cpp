@@ -4,6 +4,7 @@ lua_State *L = nullptr;
 ma_engine *audioengine = nullptr;
 SDL_Renderer *renderer = nullptr;
 struct viewport viewport{};
+struct input input{};
 
 engine::engine() {
   const auto buffer = io::read("scripts/main.lua");
@@ -37,6 +38,16 @@ engine::engine() {
   const auto fullscreen = lua_isboolean(L, -1) ? lua_toboolean(L, -1) : 0;
   lua_pop(L, 1);
 
+  lua_getfield(L, -1, "texture_budget");
+  const auto budget = lua_isnumber(L, -1) ? static_cast<size_t>(lua_tonumber(L, -1)) : 256uz;
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "collision");
+  const std::string_view backend = lua_isstring(L, -1) ? lua_tostring(L, -1) : "physics";
+  assert((backend == "physics" || backend == "overlap") && "collision must be \"physics\" or \"overlap\"");
+  const auto mode = backend == "overlap" ? collision::overlap : collision::physics;
+  lua_pop(L, 1);
+
   static const auto window = SDL_CreateWindow(
     title, width, height,
     fullscreen ? SDL_WINDOW_FULLSCREEN : 0
@@ -75,7 +86,8 @@ engine::engine() {
   lua_getfield(L, -1, "stage");
   const std::string_view initial = lua_isstring(L, -1) ? lua_tostring(L, -1) : "test";
 
-  _manager = std::make_unique<manager>();
+  _manager = std::make_unique<manager>(budget * 1024 * 1024, mode);
+  _recorder = std::make_unique<recorder>();
   _manager->request(initial);
 
   lua_pop(L, 2);
@@ -101,6 +113,25 @@ engine::engine() {
       return 1;
     }
 
+    if (key == "snapshot") {
+      lua_pushcfunction(L, [](lua_State* L) -> int {
+        auto* mgr = static_cast<manager*>(lua_touserdata(L, 1));
+        lua_pushinteger(L, static_cast<lua_Integer>(mgr->snapshot()));
+        return 1;
+      });
+      return 1;
+    }
+
+    if (key == "restore") {
+      lua_pushcfunction(L, [](lua_State* L) -> int {
+        auto* mgr = static_cast<manager*>(lua_touserdata(L, 1));
+        const auto handle = static_cast<uint32_t>(luaL_checkinteger(L, 2));
+        lua_pushboolean(L, mgr->restore(handle));
+        return 1;
+      });
+      return 1;
+    }
+
     return 0;
   });
   lua_setfield(L, -2, "__index");
@@ -169,9 +200,14 @@ void engine::loop() {
   const auto now = SDL_GetPerformanceCounter();
   static auto prior = now;
   static const auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
-  const auto delta = std::min(static_cast<float>(static_cast<double>(now - prior) / frequency), .05f);
+  auto delta = std::min(static_cast<float>(static_cast<double>(now - prior) / frequency), .05f);
   prior = now;
 
+  if (!_recorder->advance(delta)) [[unlikely]] {
+    _running = false;
+    return;
+  }
+
   static auto tick = now;
   static auto frames = 0;
   ++frames;
@@ -183,12 +219,14 @@ void engine::loop() {
     lua_gc(L, LUA_GCCOLLECT, 0);
     const auto fps = frames / elapsed;
     const auto memory = lua_gc(L, LUA_GCCOUNT, 0);
-    std::println("{:.1f} {}KB", fps, memory);
+    const auto& stats = _manager->stats();
+    std::println("{:.1f} {}KB {} drawn {} culled {} batches", fps, memory, stats.drawn, stats.culled, stats.batches);
     frames = 0;
     tick = now;
   }
 
   _manager->update(delta);
+  _recorder->track(_manager->current());
 
   SDL_RenderClear(renderer);
 
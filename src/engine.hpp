@@ -3,6 +3,7 @@
 #include "common.hpp"
 
 class manager;
+class recorder;
 
 class engine final {
 public:
@@ -16,4 +17,5 @@ public:
 private:
   bool _running{true};
   std::unique_ptr<manager> _manager;
+  std::unique_ptr<recorder> _recorder;
 };
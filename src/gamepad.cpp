@@ -53,25 +53,25 @@ static int gamepad_rumble(lua_State *state) {
 
 static int push_axis(lua_State *state, bool ok, SDL_GamepadAxis a) {
   if (ok) [[likely]]
-    return lua_pushnumber(state, static_cast<double>(deadzone(SDL_GetGamepadAxis(pad.get(), a)))), 1;
+    return lua_pushnumber(state, static_cast<double>(deadzone(input.axes[a]))), 1;
   return lua_pushnumber(state, 0), 1;
 }
 
 static int push_button(lua_State *state, bool ok, SDL_GamepadButton b) {
   if (ok) [[likely]]
-    return lua_pushboolean(state, SDL_GetGamepadButton(pad.get(), b)), 1;
+    return lua_pushboolean(state, (input.pad >> b) & 1), 1;
   return lua_pushboolean(state, false), 1;
 }
 
 static int gamepad_index(lua_State *state) {
   const std::string_view name = luaL_checkstring(state, 2);
-  const bool ok = valid();
+  const bool ok = input.connected;
 
   if (name == "connected")      return lua_pushboolean(state, ok), 1;
   if (name == "rumble")          return lua_pushcfunction(state, gamepad_rumble), 1;
 
   if (name == "name") {
-    if (ok) [[likely]]
+    if (ok && valid()) [[likely]]
       return lua_pushstring(state, SDL_GetGamepadName(pad.get())), 1;
     return lua_pushstring(state, ""), 1;
   }
@@ -102,6 +102,22 @@ static int gamepad_index(lua_State *state) {
   return lua_pushnil(state), 1;
 }
 
+void gamepad::sample(struct input& in) {
+  in.connected = valid();
+  in.axes.fill(0);
+  in.pad = 0;
+  if (!in.connected) [[unlikely]]
+    return;
+
+  for (auto a = 0; a < SDL_GAMEPAD_AXIS_COUNT; ++a)
+    in.axes[static_cast<size_t>(a)] = SDL_GetGamepadAxis(pad.get(), static_cast<SDL_GamepadAxis>(a));
+
+  for (auto b = 0; b < SDL_GAMEPAD_BUTTON_COUNT; ++b) {
+    if (SDL_GetGamepadButton(pad.get(), static_cast<SDL_GamepadButton>(b)))
+      in.pad |= 1u << b;
+  }
+}
+
 void gamepad::wire() {
   lua_newuserdata(L, 1);
 
@@ -1,5 +1,9 @@
 #pragma once
 
+struct input;
+
 namespace gamepad {
   void wire();
+
+  void sample(struct input& in);
 }
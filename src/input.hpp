@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common.hpp"
+
+// What scripts can read from the keyboard, mouse and gamepad during one frame. It is filled once per
+// frame, from SDL or from a replayed recording, so scripts never poll the devices themselves.
+struct input final {
+  std::array<uint64_t, SDL_SCANCODE_COUNT / 64> keys{};
+  float x{};
+  float y{};
+  uint32_t buttons{};
+  bool connected{};
+  std::array<int16_t, SDL_GAMEPAD_AXIS_COUNT> axes{};
+  uint32_t pad{};
+
+  [[nodiscard]] bool pressed(SDL_Scancode code) const noexcept {
+    return (keys[code / 64] >> (code % 64)) & 1;
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<input>);
+static_assert(SDL_GAMEPAD_BUTTON_COUNT <= 32);
+
+extern struct input input;
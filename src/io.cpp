@@ -20,6 +20,18 @@ std::vector<uint8_t> io::read(std::string_view filename) {
   return buffer;
 }
 
+std::vector<uint8_t> io::peek(std::string_view filename, std::size_t length) {
+  const auto ptr = std::unique_ptr<PHYSFS_File, PHYSFS_Deleter>(PHYSFS_openRead(filename.data()));
+  if (!ptr) [[unlikely]]
+    throw std::runtime_error(std::format("[PHYSFS_openRead] error while opening file: {}", filename));
+
+  std::vector<uint8_t> buffer(length);
+  const auto result = PHYSFS_readBytes(ptr.get(), buffer.data(), length);
+  buffer.resize(result > 0 ? static_cast<std::size_t>(result) : 0);
+
+  return buffer;
+}
+
 std::vector<std::string> io::enumerate(std::string_view directory) {
   std::unique_ptr<char*[], PHYSFS_Deleter> ptr(PHYSFS_enumerateFiles(directory.data()));
   assert(ptr != nullptr && "[PHYSFS_enumerateFiles] error while enumerating directory");
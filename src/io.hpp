@@ -11,5 +11,7 @@ public:
 
   [[nodiscard]] static std::vector<uint8_t> read(std::string_view filename);
 
+  [[nodiscard]] static std::vector<uint8_t> peek(std::string_view filename, std::size_t length);
+
   [[nodiscard]] static std::vector<std::string> enumerate(std::string_view directory);
 };
\ No newline at end of file
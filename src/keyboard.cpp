@@ -29,10 +29,19 @@ static int keyboard_index(lua_State *state) {
   if (it == mapping.end()) [[unlikely]]
     return lua_pushnil(state), 1;
 
+  lua_pushboolean(state, input.pressed(it->second));
+  return 1;
+}
+
+void keyboard::sample(struct input& in) {
   int keys;
   const auto *keyboard = SDL_GetKeyboardState(&keys);
-  lua_pushboolean(state, keyboard[it->second]);
-  return 1;
+
+  in.keys.fill(0);
+  for (const auto& [name, code] : mapping) {
+    if (keyboard[code])
+      in.keys[code / 64] |= uint64_t{1} << (code % 64);
+  }
 }
 
 void keyboard::wire() {
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "common.hpp"
+
+// A bitmap font: one atlas entry per character, named prefix followed by the character.
+struct font final {
+  uint32_t atlas{};
+  std::array<uint32_t, 256> glyphs{};
+  float spacing{};
+  float space{};
+  float leading{};
+};
+
+struct fonts final {
+  std::vector<font> entries;
+  std::unordered_map<entt::id_type, uint32_t> lookup;
+};
+
+// Text laid out into quads once; the quads are reused until the string or its position changes.
+struct legible final {
+  uint32_t face{};
+  std::string content;
+  float x{};
+  float y{};
+  uint8_t alpha{255};
+  bool shown{true};
+  bool dirty{true};
+  std::vector<SDL_FPoint> positions;
+  std::vector<SDL_FPoint> uvs;
+};
+
+struct textproxy final {
+  entt::registry* registry;
+  entt::entity entity;
+};
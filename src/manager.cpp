@@ -1,8 +1,8 @@
 #include "manager.hpp"
 
-manager::manager()
-    : _atlasregistry(std::make_unique<atlasregistry>())
-    , _compositor(std::make_unique<compositor>(*_atlasregistry))
+manager::manager(size_t budget, collision collision)
+    : _atlasregistry(std::make_unique<atlasregistry>(budget))
+    , _compositor(std::make_unique<compositor>())
     , _soundregistry(std::make_unique<soundregistry>()) {
   const auto entries = io::enumerate("stages");
 
@@ -10,7 +10,7 @@ manager::manager()
     if (!entry.ends_with(".lua")) continue;
 
     auto name = std::filesystem::path{entry}.stem().string();
-    _stages.emplace(name, std::make_unique<stage>(name, *_atlasregistry, *_compositor, *_soundregistry));
+    _stages.emplace(name, std::make_unique<stage>(name, *_atlasregistry, *_compositor, *_soundregistry, collision));
   }
 }
 
@@ -56,8 +56,11 @@ void manager::update(float delta) {
     auto* const next = it->second.get();
 
     if (_active != next) {
+      _atlasregistry->acquire(next->atlases());
+
       if (_active) {
         _active->on_leave();
+        _atlasregistry->release(_active->atlases());
       }
 
       _active = next;
@@ -78,4 +81,20 @@ void manager::draw() {
 
   _active->on_draw();
   _compositor->draw();
+  _atlasregistry->sweep();
+}
+
+uint32_t manager::snapshot() {
+  assert(_active && "no active stage to snapshot");
+  return _active->snapshot();
+}
+
+bool manager::restore(uint32_t handle) {
+  if (!_active) return false;
+
+  return _active->restore(handle);
+}
+
+const compositor::statistics& manager::stats() const noexcept {
+  return _compositor->stats();
 }
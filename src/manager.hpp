@@ -7,7 +7,7 @@ class soundregistry;
 
 class manager final {
 public:
-  manager();
+  manager(size_t budget, collision collision);
   ~manager();
 
   void request(std::string_view name);
@@ -20,6 +20,12 @@ public:
 
   void draw();
 
+  [[nodiscard]] uint32_t snapshot();
+
+  bool restore(uint32_t handle);
+
+  const compositor::statistics& stats() const noexcept;
+
 private:
   std::unique_ptr<atlasregistry> _atlasregistry;
   std::unique_ptr<compositor> _compositor;
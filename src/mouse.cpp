@@ -4,33 +4,23 @@ static int mouse_index(lua_State *state) {
   const std::string_view key = luaL_checkstring(state, 2);
 
   if (key == "x") {
-    float x, y;
-    SDL_GetMouseState(&x, &y);
-    SDL_RenderCoordinatesFromWindow(renderer, x, y, &x, &y);
-    lua_pushnumber(state, static_cast<double>(x));
+    lua_pushnumber(state, static_cast<double>(input.x));
     return 1;
   }
 
   if (key == "y") {
-    float x, y;
-    SDL_GetMouseState(&x, &y);
-    SDL_RenderCoordinatesFromWindow(renderer, x, y, &x, &y);
-    lua_pushnumber(state, static_cast<double>(y));
+    lua_pushnumber(state, static_cast<double>(input.y));
     return 1;
   }
 
   if (key == "xy") {
-    float x, y;
-    SDL_GetMouseState(&x, &y);
-    SDL_RenderCoordinatesFromWindow(renderer, x, y, &x, &y);
-    lua_pushnumber(state, static_cast<double>(x));
-    lua_pushnumber(state, static_cast<double>(y));
+    lua_pushnumber(state, static_cast<double>(input.x));
+    lua_pushnumber(state, static_cast<double>(input.y));
     return 2;
   }
 
   if (key == "button") {
-    float x, y;
-    const auto button = SDL_GetMouseState(&x, &y);
+    const auto button = input.buttons;
     if (button & SDL_BUTTON_MASK(SDL_BUTTON_LEFT))
       return lua_pushinteger(state, SDL_BUTTON_LEFT), 1;
     if (button & SDL_BUTTON_MASK(SDL_BUTTON_MIDDLE))
@@ -63,6 +53,14 @@ static int mouse_newindex(lua_State *state) {
   return 0;
 }
 
+void mouse::sample(struct input& in) {
+  float x, y;
+  in.buttons = SDL_GetMouseState(&x, &y);
+  SDL_RenderCoordinatesFromWindow(renderer, x, y, &x, &y);
+  in.x = x;
+  in.y = y;
+}
+
 void mouse::wire() {
   lua_newuserdata(L, 1);
 
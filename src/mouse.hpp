@@ -1,5 +1,9 @@
 #pragma once
 
+struct input;
+
 namespace mouse {
   void wire();
+
+  void sample(struct input& in);
 }
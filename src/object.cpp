@@ -4,12 +4,13 @@
 namespace {
   struct objectproxy final {
     entt::registry* registry;
+    const atlasregistry* atlases;
     entt::entity entity;
     int object_ref{LUA_NOREF};
     entt::id_type name{};
 
-    objectproxy(entt::registry& registry, entt::entity entity, int object_ref, entt::id_type name) noexcept
-        : registry(&registry), entity(entity), object_ref(object_ref), name(name) {}
+    objectproxy(entt::registry& registry, const atlasregistry& atlases, entt::entity entity, int object_ref, entt::id_type name) noexcept
+        : registry(&registry), atlases(&atlases), entity(entity), object_ref(object_ref), name(name) {}
 
     ~objectproxy() noexcept = default;
   };
@@ -18,6 +19,14 @@ namespace {
     return entt::hashed_string::value(value.data(), value.size());
   }
 
+  // Resolves an atlas/entry pair to dense indices once, so the per-frame passes index arrays instead of hashing.
+  mapping resolve(const atlasregistry& atlases, entt::id_type name, std::string_view atlas_name, std::string_view entry_name) {
+    const auto index = atlases.resolve(hash(atlas_name));
+    const auto animation = atlases.at(index).resolve(hash(entry_name));
+    assert(animation != atlas::none && "animation entry not found in atlas");
+    return {name, index, animation};
+  }
+
   const mapping* find_mapping(const mappable& m, entt::id_type name) {
     for (uint32_t i = 0; i < m.count; ++i) {
       if (m.mappings[i].name == name) return &m.mappings[i];
@@ -25,16 +34,59 @@ namespace {
     return nullptr;
   }
 
-  void detach_shape(collidable& c) {
-    if (b2Shape_IsValid(c.shape)) {
-      b2DestroyShape(c.shape, false);
-      c.shape = b2ShapeId{};
+  // body = "static" | "kinematic" | "dynamic"; unrelated to static = true, which bakes the sprite into a layer.
+  b2BodyType body_type(std::string_view name) {
+    if (name == "static") return b2_staticBody;
+    if (name == "kinematic") return b2_kinematicBody;
+
+    assert(name == "dynamic" && "body must be \"static\", \"kinematic\" or \"dynamic\"");
+    return b2_dynamicBody;
+  }
+
+  void invalidate(entt::registry& registry, entt::entity entity) {
+    registry.ctx().get<layers>().touch(registry, entity);
+    registry.emplace_or_replace<moved>(entity);
+
+    if (registry.all_of<collidable>(entity))
+      registry.emplace_or_replace<displaced>(entity);
+  }
+
+  void detach_shapes(collidable& c) {
+    for (uint32_t i = 0; i < c.count; ++i) {
+      if (b2Shape_IsValid(c.shapes[i])) b2DestroyShape(c.shapes[i], false);
+      c.shapes[i] = b2ShapeId{};
+    }
+
+    c.count = 0;
+    c.outline = atlas::none;
+    c.scale = {};
+  }
+
+  // Reuses the shapes the body already has, creating or destroying only the difference in count.
+  void attach_shapes(entt::entity entity, collidable& c, std::span<const b2Polygon> polygons) {
+    const auto n = static_cast<uint32_t>(polygons.size());
+
+    for (uint32_t i = 0; i < n; ++i) {
+      if (i < c.count) {
+        b2Shape_SetPolygon(c.shapes[i], &polygons[i]);
+        continue;
+      }
+
+      auto def = b2DefaultShapeDef();
+      def.isSensor = true;
+      def.enableSensorEvents = true;
+      def.filter.categoryBits = c.category;
+      def.filter.maskBits = c.mask;
+      def.userData = reinterpret_cast<void*>(static_cast<std::uintptr_t>(entity));
+      c.shapes[i] = b2CreatePolygonShape(c.body, &def, &polygons[i]);
     }
 
-    c.hx = {};
-    c.hy = {};
-    c.hw = {};
-    c.hh = {};
+    for (auto i = n; i < c.count; ++i) {
+      b2DestroyShape(c.shapes[i], false);
+      c.shapes[i] = b2ShapeId{};
+    }
+
+    c.count = n;
   }
 
   int object_destroy(lua_State* state) {
@@ -94,6 +146,11 @@ namespace {
       return 1;
     }
 
+    if (key == "parallax") {
+      lua_pushnumber(state, static_cast<double>(registry.get<transform>(entity).parallax));
+      return 1;
+    }
+
     if (key == "alpha") {
       lua_pushnumber(state, static_cast<double>(registry.get<transform>(entity).alpha));
       return 1;
@@ -108,7 +165,7 @@ namespace {
       const auto& r = registry.get<renderable>(entity);
       const auto& m = registry.get<mappable>(entity);
       for (uint32_t i = 0; i < m.count; ++i) {
-        if (m.mappings[i].atlas == r.atlas && m.mappings[i].entry == r.entry) {
+        if (m.mappings[i].atlas == r.atlas && m.mappings[i].animation == r.animation) {
           const auto& lu = registry.ctx().get<lookupable>();
           const auto it = lu.names.find(m.mappings[i].name);
           if (it != lu.names.end()) {
@@ -174,10 +231,7 @@ namespace {
     if (key == "x") {
       auto& t = registry.get<transform>(entity);
       t.x = static_cast<float>(luaL_checknumber(state, 3));
-
-      auto* c = registry.try_get<collidable>(entity);
-      if (c && b2Body_IsValid(c->body))
-        b2Body_SetTransform(c->body, {t.x + c->ox, t.y + c->oy}, b2Rot_identity);
+      invalidate(registry, entity);
 
       return 0;
     }
@@ -185,10 +239,7 @@ namespace {
     if (key == "y") {
       auto& t = registry.get<transform>(entity);
       t.y = static_cast<float>(luaL_checknumber(state, 3));
-
-      auto* c = registry.try_get<collidable>(entity);
-      if (c && b2Body_IsValid(c->body))
-        b2Body_SetTransform(c->body, {t.x + c->ox, t.y + c->oy}, b2Rot_identity);
+      invalidate(registry, entity);
 
       return 0;
     }
@@ -206,21 +257,37 @@ namespace {
 
     if (key == "scale") {
       registry.get<transform>(entity).scale = static_cast<float>(luaL_checknumber(state, 3));
+      invalidate(registry, entity);
       return 0;
     }
 
     if (key == "angle") {
       registry.get<transform>(entity).angle = static_cast<float>(luaL_checknumber(state, 3));
+      invalidate(registry, entity);
+      return 0;
+    }
+
+    if (key == "parallax") {
+      auto& t = registry.get<transform>(entity);
+      const auto value = static_cast<float>(luaL_checknumber(state, 3));
+      if (t.parallax != value) {
+        t.parallax = value;
+        if (registry.all_of<stationary>(entity))
+          registry.ctx().get<dirtable>().mark(dirtable::layout);
+      }
+
       return 0;
     }
 
     if (key == "alpha") {
       registry.get<transform>(entity).alpha = static_cast<uint8_t>(luaL_checknumber(state, 3));
+      invalidate(registry, entity);
       return 0;
     }
 
     if (key == "shown") {
       registry.get<transform>(entity).shown = lua_toboolean(state, 3) != 0;
+      invalidate(registry, entity);
       return 0;
     }
 
@@ -237,8 +304,9 @@ namespace {
         const auto entry_name = luaL_checkstring(state, -1);
         lua_pop(state, 1);
 
-        r.atlas = hash(atlas_name);
-        r.entry = hash(entry_name);
+        const auto mp = resolve(*proxy->atlases, {}, atlas_name, entry_name);
+        r.atlas = mp.atlas;
+        r.animation = mp.animation;
       } else {
         const auto value = luaL_checkstring(state, 3);
         const auto id = hash(value);
@@ -247,11 +315,12 @@ namespace {
         assert(mp && "animation mapping not found");
 
         r.atlas = mp->atlas;
-        r.entry = mp->entry;
+        r.animation = mp->animation;
       }
 
       r.current_frame = 0;
-      r.counter = 0;
+      animator::schedule(registry, *proxy->atlases, entity);
+      invalidate(registry, entity);
 
       return 0;
     }
@@ -308,6 +377,10 @@ namespace {
       b2DestroyBody(c->body);
   }
 
+  void on_layout_change(entt::registry& registry, entt::entity) {
+    registry.ctx().get<dirtable>().mark(dirtable::layout);
+  }
+
   void wire() {
     luaL_newmetatable(L, "Object");
 
@@ -329,6 +402,8 @@ void object::setup(entt::registry& registry) {
   std::call_once(once, wire);
 
   registry.on_destroy<scriptable>().connect<&on_destroy_scriptable>();
+  registry.on_construct<sorteable>().connect<&on_layout_change>();
+  registry.on_destroy<stationary>().connect<&on_layout_change>();
 }
 
 void object::create(
@@ -338,7 +413,9 @@ void object::create(
   std::string_view kind,
   float x,
   float y,
-  std::string_view initial_animation
+  std::string_view initial_animation,
+  bool still,
+  std::string_view body
 ) {
   auto& registry = stage._registry;
   auto& world = stage._world;
@@ -349,6 +426,8 @@ void object::create(
   registry.emplace<sorteable>(entity, sorteable{z});
   registry.emplace<transform>(entity, x, y);
   auto& r = registry.emplace<renderable>(entity);
+  registry.emplace<bounded>(entity);
+  registry.emplace<moved>(entity);
 
   assert(!initial_animation.empty() && "object must have an initial animation");
   const auto initial_id = hash(initial_animation);
@@ -377,6 +456,12 @@ void object::create(
   auto on_collision_end_ref = LUA_NOREF;
   auto on_screen_exit_ref = LUA_NOREF;
   auto on_screen_enter_ref = LUA_NOREF;
+  auto is_static = still;
+  auto type = b2_dynamicBody;
+  uint64_t category = B2_DEFAULT_CATEGORY_BITS;
+  uint64_t mask = B2_DEFAULT_MASK_BITS;
+  auto& cs = registry.ctx().get<categories>();
+  std::vector<std::string> remembered;
 
   lua_pushnil(L);
   while (lua_next(L, -2) != 0) {
@@ -387,7 +472,23 @@ void object::create(
 
     const std::string_view field = lua_tostring(L, -2);
 
-    if (lua_istable(L, -1)) {
+    if (lua_istable(L, -1) && field == "collides_with") {
+      mask = 0;
+      const auto count = static_cast<int>(lua_objlen(L, -1));
+      for (int i = 1; i <= count; ++i) {
+        lua_rawgeti(L, -1, i);
+        mask |= cs.bit(hash(luaL_checkstring(L, -1)));
+        lua_pop(L, 1);
+      }
+    } else if (lua_istable(L, -1) && field == "snapshot") {
+      const auto count = static_cast<int>(lua_objlen(L, -1));
+      assert(count <= std::numeric_limits<uint8_t>::max() && "too many snapshot fields");
+      for (int i = 1; i <= count; ++i) {
+        lua_rawgeti(L, -1, i);
+        remembered.emplace_back(luaL_checkstring(L, -1));
+        lua_pop(L, 1);
+      }
+    } else if (lua_istable(L, -1)) {
       lua_rawgeti(L, -1, 1);
       const bool is_mapping = lua_isstring(L, -1);
       lua_pop(L, 1);
@@ -403,12 +504,18 @@ void object::create(
 
         assert(m.count < m.mappings.size() && "too many mappings");
         auto& mp = m.mappings[m.count++];
-        mp.name = hash(field);
-        mp.atlas = hash(atlas_name);
-        mp.entry = hash(entry_name);
+        mp = resolve(atlasregistry, hash(field), atlas_name, entry_name);
 
         registry.ctx().get<lookupable>().names.emplace(mp.name, field);
       }
+    } else if (lua_type(L, -1) == LUA_TSTRING) {
+      if (field == "layer")
+        category = cs.bit(hash(lua_tostring(L, -1)));
+      else if (field == "body")
+        type = body_type(lua_tostring(L, -1));
+    } else if (lua_isboolean(L, -1)) {
+      if (field == "static")
+        is_static = is_static || lua_toboolean(L, -1) != 0;
     } else if (lua_isfunction(L, -1)) {
       if (field == "on_spawn") {
         on_spawn_ref = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -439,12 +546,20 @@ void object::create(
 
   const auto object_ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
+  // The table ref is owned by the object proxy; rememberable only borrows it and goes with the entity.
+  if (!remembered.empty())
+    registry.emplace<rememberable>(entity, object_ref, std::move(remembered));
+
   registry.emplace<mappable>(entity, m.mappings, m.count);
 
   const auto* mp = find_mapping(m, initial_id);
   assert(mp && "initial animation mapping not found in object");
   r.atlas = mp->atlas;
-  r.entry = mp->entry;
+  r.animation = mp->animation;
+  animator::schedule(registry, atlasregistry, entity);
+
+  if (is_static)
+    registry.emplace<stationary>(entity);
 
   registry.emplace<identifiable>(entity, hash(kind), hash(name));
   auto& scriptable = registry.emplace<::scriptable>(entity);
@@ -456,10 +571,16 @@ void object::create(
   scriptable.on_screen_exit = on_screen_exit_ref;
   scriptable.on_screen_enter = on_screen_enter_ref;
 
-  const auto& kf = atlasregistry.get(r.atlas).keyframe_at(r.entry, 0);
-  if (kf.sprite.hw > 0 && kf.sprite.hh > 0) {
+  if (!body.empty())
+    type = body_type(body);
+
+  const auto& a = atlasregistry.at(r.atlas);
+  const auto solid = a.outline(a.keyframe(r.animation, 0)) != atlas::none;
+  if (solid && stage._collision == collision::overlap) {
+    registry.emplace<overlappable>(entity, category, mask, type);
+  } else if (solid) {
     auto def = b2DefaultBodyDef();
-    def.type = b2_dynamicBody;
+    def.type = type;
     def.fixedRotation = true;
     def.gravityScale = .0f;
     def.position = {x, y};
@@ -467,6 +588,9 @@ void object::create(
 
     auto& c = registry.emplace<collidable>(entity);
     c.body = b2CreateBody(world, &def);
+    c.category = category;
+    c.mask = mask;
+    registry.emplace<displaced>(entity);
   }
 
   auto& lu = registry.ctx().get<lookupable>();
@@ -478,7 +602,7 @@ void object::create(
 
   lua_rawgeti(L, LUA_REGISTRYINDEX, pool);
   auto* memory = lua_newuserdata(L, sizeof(objectproxy));
-  new (memory) objectproxy(registry, entity, object_ref, nid);
+  new (memory) objectproxy(registry, atlasregistry, entity, object_ref, nid);
   luaL_getmetatable(L, "Object");
   lua_setmetatable(L, -2);
   lua_pushvalue(L, -1);
@@ -497,46 +621,25 @@ void object::create(
   }
 }
 
+// Brings bodies in line with objects that moved, rescaled or changed hitbox since the last sync; the rest are not touched.
 void object::update(entt::registry& registry, atlasregistry& atlasregistry) {
-  for (auto&& [entity, t, r, c] : registry.view<transform, renderable, collidable>().each()) {
-    const auto& kf = atlasregistry.get(r.atlas).keyframe_at(r.entry, r.current_frame);
-    const auto& sprite = kf.sprite;
+  for (auto&& [entity, t, r, c] : registry.view<displaced, transform, renderable, collidable>().each()) {
+    auto& a = atlasregistry.at(r.atlas);
+    const auto outline = a.outline(a.keyframe(r.animation, r.current_frame));
 
-    if (sprite.hw == 0 || sprite.hh == 0 || t.alpha == 0) [[unlikely]] {
-      detach_shape(c);
+    if (outline == atlas::none || t.alpha == 0) [[unlikely]] {
+      detach_shapes(c);
       continue;
     }
 
-    const auto shx = sprite.hx * t.scale;
-    const auto shy = sprite.hy * t.scale;
-    const auto shw = sprite.hw * t.scale;
-    const auto shh = sprite.hh * t.scale;
-
-    const auto sw = sprite.w * t.scale;
-    const auto sh = sprite.h * t.scale;
-    const auto ox = -sw * .5f + shx + shw * .5f;
-    const auto oy = -sh * .5f + shy + shh * .5f;
-
-    if (shw != c.hw || shh != c.hh || shx != c.hx || shy != c.hy) {
-      const auto poly = b2MakeBox(shw * .5f, shh * .5f);
-      if (b2Shape_IsValid(c.shape)) {
-        b2Shape_SetPolygon(c.shape, &poly);
-      } else {
-        auto def = b2DefaultShapeDef();
-        def.isSensor = true;
-        def.enableSensorEvents = true;
-        def.userData = reinterpret_cast<void*>(static_cast<std::uintptr_t>(entity));
-        c.shape = b2CreatePolygonShape(c.body, &def, &poly);
-      }
-
-      c.hx = shx;
-      c.hy = shy;
-      c.hw = shw;
-      c.hh = shh;
+    if (outline != c.outline || t.scale != c.scale) {
+      attach_shapes(entity, c, a.polygons(outline, t.scale));
+      c.outline = outline;
+      c.scale = t.scale;
     }
 
-    c.ox = ox;
-    c.oy = oy;
-    b2Body_SetTransform(c.body, {t.x + ox, t.y + oy}, b2Rot_identity);
+    b2Body_SetTransform(c.body, {t.x, t.y}, b2Rot_identity);
   }
+
+  registry.clear<displaced>();
 }
@@ -12,7 +12,9 @@ namespace object {
     std::string_view kind,
     float x,
     float y,
-    std::string_view initial_animation
+    std::string_view initial_animation,
+    bool still,
+    std::string_view body
   );
 
   void update(entt::registry& registry, atlasregistry& atlasregistry);
@@ -0,0 +1,85 @@
+#include "opusstream.hpp"
+
+opusstream::opusstream(std::string_view filename)
+    : _buffer(io::read(filename)) {
+  auto error = 0;
+  _codec = op_open_memory(_buffer.data(), _buffer.size(), &error);
+  assert((error == 0) && "[op_open_memory] failed to decode");
+
+  _channels = static_cast<ma_uint32>(op_channel_count(_codec, -1));
+
+  auto config = ma_data_source_config_init();
+  config.vtable = &vtable;
+  ma_data_source_init(&config, &_base);
+}
+
+opusstream::~opusstream() noexcept {
+  ma_data_source_uninit(&_base);
+  op_free(_codec);
+}
+
+ma_data_source* opusstream::source() noexcept {
+  return &_base;
+}
+
+// Called on the audio thread. op_read_float stops at packet boundaries, so it is called until the
+// request is filled; the rest of a packet stays buffered inside opusfile for the next call.
+ma_result opusstream::read(ma_data_source* source, void* out, ma_uint64 count, ma_uint64* done) {
+  auto* self = reinterpret_cast<opusstream*>(source);
+  auto* samples = static_cast<float*>(out);
+
+  ma_uint64 total = 0;
+  while (total < count) {
+    const auto remaining = std::min<ma_uint64>(count - total, std::numeric_limits<int>::max() / self->_channels);
+    const auto frames = op_read_float(
+      self->_codec,
+      samples + total * self->_channels,
+      static_cast<int>(remaining * self->_channels),
+      nullptr
+    );
+
+    if (frames == OP_HOLE) {
+      continue;
+    }
+
+    if (frames <= 0) {
+      break;
+    }
+
+    total += static_cast<ma_uint64>(frames);
+  }
+
+  if (done) *done = total;
+
+  return total == 0 ? MA_AT_END : MA_SUCCESS;
+}
+
+ma_result opusstream::seek(ma_data_source* source, ma_uint64 frame) {
+  auto* self = reinterpret_cast<opusstream*>(source);
+  return op_pcm_seek(self->_codec, static_cast<ogg_int64_t>(frame)) == 0 ? MA_SUCCESS : MA_ERROR;
+}
+
+ma_result opusstream::format(ma_data_source* source, ma_format* sample, ma_uint32* channels, ma_uint32* rate, ma_channel* map, size_t capacity) {
+  const auto* self = reinterpret_cast<opusstream*>(source);
+
+  if (sample) *sample = ma_format_f32;
+  if (channels) *channels = self->_channels;
+  if (rate) *rate = 48000;
+  if (map) ma_channel_map_init_standard(ma_standard_channel_map_default, map, capacity, self->_channels);
+
+  return MA_SUCCESS;
+}
+
+ma_result opusstream::cursor(ma_data_source* source, ma_uint64* position) {
+  auto* self = reinterpret_cast<opusstream*>(source);
+  const auto at = op_pcm_tell(self->_codec);
+  *position = at < 0 ? 0 : static_cast<ma_uint64>(at);
+  return MA_SUCCESS;
+}
+
+ma_result opusstream::length(ma_data_source* source, ma_uint64* frames) {
+  auto* self = reinterpret_cast<opusstream*>(source);
+  const auto total = op_pcm_total(self->_codec, -1);
+  *frames = total < 0 ? 0 : static_cast<ma_uint64>(total);
+  return MA_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common.hpp"
+
+// A miniaudio data source that keeps an Opus file compressed and decodes it on the audio thread as
+// it plays, for music and long ambience that would cost tens of megabytes decoded up front.
+class opusstream final {
+public:
+  explicit opusstream(std::string_view filename);
+  ~opusstream() noexcept;
+
+  opusstream(const opusstream&) = delete;
+  opusstream& operator=(const opusstream&) = delete;
+  opusstream(opusstream&&) = delete;
+  opusstream& operator=(opusstream&&) = delete;
+
+  [[nodiscard]] ma_data_source* source() noexcept;
+
+private:
+  static ma_result read(ma_data_source* source, void* out, ma_uint64 count, ma_uint64* done);
+  static ma_result seek(ma_data_source* source, ma_uint64 frame);
+  static ma_result format(ma_data_source* source, ma_format* sample, ma_uint32* channels, ma_uint32* rate, ma_channel* map, size_t capacity);
+  static ma_result cursor(ma_data_source* source, ma_uint64* position);
+  static ma_result length(ma_data_source* source, ma_uint64* frames);
+
+  static constexpr ma_data_source_vtable vtable{read, seek, format, cursor, length, nullptr, 0};
+
+  // Must stay first: miniaudio hands the callbacks a pointer to it.
+  ma_data_source_base _base{};
+  std::vector<uint8_t> _buffer;
+  OggOpusFile* _codec{nullptr};
+  ma_uint32 _channels{};
+};
@@ -0,0 +1,125 @@
+#include "overlapper.hpp"
+
+namespace {
+  uint64_t pack(entt::entity a, entt::entity b) noexcept {
+    return static_cast<uint64_t>(entt::to_integral(a)) << 32 | entt::to_integral(b);
+  }
+
+  overlapper::pair unpack(uint64_t key) noexcept {
+    return {static_cast<entt::entity>(static_cast<uint32_t>(key >> 32)), static_cast<entt::entity>(static_cast<uint32_t>(key))};
+  }
+}
+
+void overlapper::step(entt::registry& registry, atlasregistry& atlasregistry) {
+  _boxes.clear();
+  _owners.clear();
+  _categories.clear();
+  _masks.clear();
+  _fixed.clear();
+
+  for (auto&& [entity, o, t, r] : registry.view<overlappable, transform, renderable>().each()) {
+    if (t.alpha == 0) [[unlikely]] continue;
+
+    auto& a = atlasregistry.at(r.atlas);
+    const auto outline = a.outline(a.keyframe(r.animation, r.current_frame));
+    if (outline == atlas::none) continue;
+
+    const b2Transform at{{t.x, t.y}, b2Rot_identity};
+    for (const auto& p : a.polygons(outline, t.scale)) {
+      _boxes.push_back(b2ComputePolygonAABB(&p, at));
+      _owners.push_back(entity);
+      _categories.push_back(o.category);
+      _masks.push_back(o.mask);
+      _fixed.push_back(o.type == b2_staticBody);
+    }
+  }
+
+  // Solid tiles join as static boxes owned by the tilemap, so objects see the map as they do under physics.
+  auto passive = entt::entity{entt::null};
+  if (const auto* tm = registry.ctx().find<tilemap>(); tm && tm->entity() != entt::null) {
+    passive = tm->entity();
+
+    for (const auto& chunk : tm->solids()) {
+      for (const auto& box : chunk) {
+        _boxes.push_back(box);
+        _owners.push_back(passive);
+        _categories.push_back(tm->category());
+        _masks.push_back(tm->mask());
+        _fixed.push_back(true);
+      }
+    }
+  }
+
+  // The order survives between steps; objects move a little each step, so the insertion sort
+  // mostly just confirms it.
+  const auto n = static_cast<uint32_t>(_boxes.size());
+  if (_order.size() != n) {
+    _order.resize(n);
+    std::iota(_order.begin(), _order.end(), 0u);
+  }
+
+  for (uint32_t i = 1; i < n; ++i) {
+    const auto index = _order[i];
+    const auto x = _boxes[index].lowerBound.x;
+
+    auto j = i;
+    for (; j > 0 && _boxes[_order[j - 1]].lowerBound.x > x; --j) {
+      _order[j] = _order[j - 1];
+    }
+
+    _order[j] = index;
+  }
+
+  _pairs.clear();
+  _active.clear();
+
+  for (const auto i : _order) {
+    const auto& box = _boxes[i];
+
+    std::erase_if(_active, [&](uint32_t j) { return _boxes[j].upperBound.x < box.lowerBound.x; });
+
+    for (const auto j : _active) {
+      if (_owners[i] == _owners[j]) continue;
+      if (_fixed[i] && _fixed[j]) continue;
+      if (!admits(_categories[i], _masks[i], _categories[j], _masks[j])) continue;
+
+      const auto& other = _boxes[j];
+      if (other.upperBound.y < box.lowerBound.y || other.lowerBound.y > box.upperBound.y) continue;
+
+      // The tilemap has no script, so only the object side of a pair with it is reported.
+      if (_owners[i] != passive) _pairs.push_back(pack(_owners[i], _owners[j]));
+      if (_owners[j] != passive) _pairs.push_back(pack(_owners[j], _owners[i]));
+    }
+
+    _active.push_back(i);
+  }
+
+  std::ranges::sort(_pairs);
+  const auto [first, last] = std::ranges::unique(_pairs);
+  _pairs.erase(first, last);
+
+  _began.clear();
+  _ended.clear();
+
+  _difference.clear();
+  std::ranges::set_difference(_pairs, _previous, std::back_inserter(_difference));
+  for (const auto key : _difference) _began.push_back(unpack(key));
+
+  _difference.clear();
+  std::ranges::set_difference(_previous, _pairs, std::back_inserter(_difference));
+  for (const auto key : _difference) _ended.push_back(unpack(key));
+
+  std::swap(_pairs, _previous);
+}
+
+std::span<const overlapper::pair> overlapper::began() const noexcept {
+  return _began;
+}
+
+std::span<const overlapper::pair> overlapper::ended() const noexcept {
+  return _ended;
+}
+
+std::span<const b2AABB> overlapper::boxes() const noexcept {
+  return _boxes;
+}
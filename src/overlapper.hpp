@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common.hpp"
+
+class atlasregistry;
+
+// Sensor-only collision for cartridges that never need rigid bodies: every step the hitboxes of
+// overlappable objects and the tilemap's solid boxes are gathered into packed bounds, swept
+// along x, and compared with the pairs found the step before.
+class overlapper final {
+public:
+  using pair = std::pair<entt::entity, entt::entity>;
+
+  void step(entt::registry& registry, atlasregistry& atlasregistry);
+
+  [[nodiscard]] std::span<const pair> began() const noexcept;
+  [[nodiscard]] std::span<const pair> ended() const noexcept;
+  [[nodiscard]] std::span<const b2AABB> boxes() const noexcept;
+
+private:
+  std::vector<b2AABB> _boxes;
+  std::vector<entt::entity> _owners;
+  std::vector<uint64_t> _categories;
+  std::vector<uint64_t> _masks;
+  std::vector<uint8_t> _fixed;
+  std::vector<uint32_t> _order;
+  std::vector<uint32_t> _active;
+  std::vector<uint64_t> _pairs;
+  std::vector<uint64_t> _previous;
+  std::vector<uint64_t> _difference;
+  std::vector<pair> _began;
+  std::vector<pair> _ended;
+};
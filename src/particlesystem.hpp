@@ -0,0 +1,15 @@
+#pragma once
+
+#include "common.hpp"
+
+class atlasregistry;
+class compositor;
+struct emissive;
+struct projection;
+
+namespace particlesystem {
+  void wire();
+  entt::entity create(entt::registry& registry, atlasregistry& atlasregistry, std::string_view kind, float x, float y);
+  void update(entt::registry& registry, float delta);
+  void draw(const emissive& e, atlasregistry& atlasregistry, compositor& compositor, const projection& p);
+}
@@ -0,0 +1,161 @@
+#include "pixmap.hpp"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif !defined(EMSCRIPTEN)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+  struct header final {
+    std::array<char, 4> magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+  };
+
+  static_assert(sizeof(header) == 16);
+
+  constexpr std::array<char, 4> signature{'P', 'X', 'M', '1'};
+
+  size_t bytes(uint32_t width, uint32_t height) noexcept {
+    return static_cast<size_t>(width) * height * 4;
+  }
+}
+
+pixmap::pixmap(uint32_t width, uint32_t height, std::unique_ptr<uint8_t[]> pixels) noexcept
+    : _width(width), _height(height), _pixels(std::move(pixels)) {
+  _data = _pixels.get();
+}
+
+pixmap::~pixmap() noexcept {
+  release();
+}
+
+pixmap::pixmap(pixmap&& other) noexcept
+    : _width(other._width)
+    , _height(other._height)
+    , _pixels(std::move(other._pixels))
+    , _data(std::exchange(other._data, nullptr))
+    , _view(std::exchange(other._view, nullptr))
+    , _length(std::exchange(other._length, 0)) {
+}
+
+pixmap& pixmap::operator=(pixmap&& other) noexcept {
+  if (this == &other) return *this;
+
+  release();
+  _width = other._width;
+  _height = other._height;
+  _pixels = std::move(other._pixels);
+  _data = std::exchange(other._data, nullptr);
+  _view = std::exchange(other._view, nullptr);
+  _length = std::exchange(other._length, 0);
+  return *this;
+}
+
+void pixmap::release() noexcept {
+  if (!_view) return;
+
+#if defined(_WIN32)
+  UnmapViewOfFile(_view);
+#elif !defined(EMSCRIPTEN)
+  munmap(_view, _length);
+#endif
+
+  _view = nullptr;
+  _length = 0;
+}
+
+std::optional<pixmap> pixmap::map(const std::filesystem::path& path) {
+#if defined(EMSCRIPTEN)
+  return std::nullopt;
+#else
+  pixmap result;
+
+#if defined(_WIN32)
+  const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return std::nullopt;
+
+  LARGE_INTEGER size{};
+  GetFileSizeEx(file, &size);
+  const auto mapping = size.QuadPart > 0
+    ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+    : nullptr;
+  CloseHandle(file);
+  if (!mapping) return std::nullopt;
+
+  result._view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!result._view) return std::nullopt;
+
+  result._length = static_cast<size_t>(size.QuadPart);
+#else
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return std::nullopt;
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return std::nullopt;
+  }
+
+  auto* const view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return std::nullopt;
+
+  result._view = view;
+  result._length = static_cast<size_t>(st.st_size);
+#endif
+
+  if (result._length < sizeof(header)) return std::nullopt;
+
+  header h;
+  std::memcpy(&h, result._view, sizeof(header));
+  if (h.magic != signature || result._length != sizeof(header) + bytes(h.width, h.height))
+    return std::nullopt;
+
+  result._width = h.width;
+  result._height = h.height;
+  result._data = static_cast<const uint8_t*>(result._view) + sizeof(header);
+  return result;
+#endif
+}
+
+void pixmap::save(const std::filesystem::path& path) const {
+#if !defined(EMSCRIPTEN)
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  if (ec) return;
+
+  auto temporary = path;
+  temporary += ".tmp";
+
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) return;
+
+    const header h{signature, _width, _height, 0};
+    file.write(reinterpret_cast<const char*>(&h), sizeof(header));
+    file.write(reinterpret_cast<const char*>(_data), static_cast<std::streamsize>(bytes(_width, _height)));
+    if (!file) return;
+  }
+
+  std::filesystem::rename(temporary, path, ec);
+#endif
+}
+
+uint32_t pixmap::width() const noexcept {
+  return _width;
+}
+
+uint32_t pixmap::height() const noexcept {
+  return _height;
+}
+
+const uint8_t* pixmap::data() const noexcept {
+  return _data;
+}
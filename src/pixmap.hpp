@@ -0,0 +1,35 @@
+#pragma once
+
+#include "common.hpp"
+
+class pixmap final {
+public:
+  pixmap(uint32_t width, uint32_t height, std::unique_ptr<uint8_t[]> pixels) noexcept;
+  ~pixmap() noexcept;
+
+  pixmap(pixmap&& other) noexcept;
+  pixmap& operator=(pixmap&& other) noexcept;
+
+  pixmap(const pixmap&) = delete;
+  pixmap& operator=(const pixmap&) = delete;
+
+  [[nodiscard]] static std::optional<pixmap> map(const std::filesystem::path& path);
+
+  void save(const std::filesystem::path& path) const;
+
+  [[nodiscard]] uint32_t width() const noexcept;
+  [[nodiscard]] uint32_t height() const noexcept;
+  [[nodiscard]] const uint8_t* data() const noexcept;
+
+private:
+  pixmap() noexcept = default;
+
+  void release() noexcept;
+
+  uint32_t _width{};
+  uint32_t _height{};
+  std::unique_ptr<uint8_t[]> _pixels;
+  const uint8_t* _data{};
+  void* _view{};
+  size_t _length{};
+};
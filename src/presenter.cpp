@@ -1,24 +1,252 @@
 #include "presenter.hpp"
 
+namespace {
+  bool visible(float x, float y, float hw, float hh) {
+    return x + hw >= .0f
+        && y + hh >= .0f
+        && x - hw <= viewport.width
+        && y - hh <= viewport.height;
+  }
+
+  std::pair<float, float> extent(const atlas::sprite& sprite, const transform& t) {
+    const auto hw = sprite.w * t.scale * .5f;
+    const auto hh = sprite.h * t.scale * .5f;
+    if (t.angle == .0f) [[likely]] return {hw, hh};
+
+    const auto radius = std::hypot(hw, hh);
+    return {radius, radius};
+  }
+
+  // Groups consecutive stationary objects into layers; a layer scrolls as one, so a parallax change starts a new one.
+  // Walks every sorteable, emitters included, so one sorted between two stationary objects splits their layer.
+  void arrange(entt::registry& registry, layers& ls) {
+    auto count = 0uz;
+    auto open = false;
+
+    for (const auto entity : registry.view<sorteable>()) {
+      auto* st = registry.try_get<stationary>(entity);
+      if (!st) {
+        open = false;
+        continue;
+      }
+
+      const auto parallax = registry.get<transform>(entity).parallax;
+      if (open && ls.entries[count - 1].parallax != parallax) open = false;
+
+      if (!open) {
+        if (count == ls.entries.size()) ls.entries.emplace_back();
+        auto& l = ls.entries[count++];
+        l.members.clear();
+        l.parallax = parallax;
+        l.dirty = true;
+        open = true;
+      }
+
+      st->layer = static_cast<uint32_t>(count - 1);
+      ls.entries[count - 1].members.push_back(entity);
+    }
+
+    ls.entries.resize(count);
+  }
+
+  void bake(entt::registry& registry, atlasregistry& atlasregistry, compositor& compositor, layer& l) {
+    l.dirty = false;
+    l.cached = false;
+
+    auto x0 = std::numeric_limits<float>::max();
+    auto y0 = std::numeric_limits<float>::max();
+    auto x1 = std::numeric_limits<float>::lowest();
+    auto y1 = std::numeric_limits<float>::lowest();
+
+    for (const auto entity : l.members) {
+      const auto& t = registry.get<transform>(entity);
+      if (!t.shown) continue;
+
+      const auto& r = registry.get<renderable>(entity);
+      const auto& a = atlasregistry.at(r.atlas);
+      const auto& sprite = a.sprites()[a.keyframe(r.animation, r.current_frame)];
+      const auto [hw, hh] = extent(sprite, t);
+
+      x0 = std::min(x0, t.x - hw);
+      y0 = std::min(y0, t.y - hh);
+      x1 = std::max(x1, t.x + hw);
+      y1 = std::max(y1, t.y + hh);
+    }
+
+    if (x0 > x1 || y0 > y1) {
+      l.texture.reset();
+      l.cached = true;
+      return;
+    }
+
+    x0 = std::floor(x0);
+    y0 = std::floor(y0);
+    const auto w = static_cast<int>(std::ceil(x1 - x0));
+    const auto h = static_cast<int>(std::ceil(y1 - y0));
+
+    const auto maximum = static_cast<int>(SDL_GetNumberProperty(
+      SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0));
+    if (w <= 0 || h <= 0 || w > maximum || h > maximum) [[unlikely]] return;
+
+    float tw = 0, th = 0;
+    if (l.texture) SDL_GetTextureSize(l.texture.get(), &tw, &th);
+    if (!l.texture || static_cast<int>(tw) != w || static_cast<int>(th) != h) {
+      l.texture = std::unique_ptr<SDL_Texture, SDL_Deleter>(
+        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h));
+      if (!l.texture) [[unlikely]] return;
+
+      SDL_SetTextureScaleMode(l.texture.get(), SDL_SCALEMODE_NEAREST);
+      SDL_SetTextureBlendMode(l.texture.get(), SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+    }
+
+    Uint8 red, green, blue, alpha;
+    SDL_GetRenderDrawColor(renderer, &red, &green, &blue, &alpha);
+
+    SDL_SetRenderTarget(renderer, l.texture.get());
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    for (const auto entity : l.members) {
+      const auto& t = registry.get<transform>(entity);
+      if (!t.shown) continue;
+
+      const auto& r = registry.get<renderable>(entity);
+      auto& a = atlasregistry.at(r.atlas);
+      atlasregistry.require(a);
+      const auto& sprite = a.sprites()[a.keyframe(r.animation, r.current_frame)];
+
+      compositor.push(a, sprite, t.x - x0, t.y - y0, t.scale, lcos(t.angle), lsin(t.angle), t.alpha);
+    }
+
+    compositor.flush();
+
+    SDL_SetRenderTarget(renderer, nullptr);
+    SDL_SetRenderDrawColor(renderer, red, green, blue, alpha);
+
+    l.bounds = {x0, y0, static_cast<float>(w), static_cast<float>(h)};
+    l.cached = true;
+  }
+}
+
+// Objects and layers live in world space and are projected through the camera with their own parallax.
 void presenter::render(entt::registry& registry, atlasregistry& atlasregistry, compositor& compositor) {
-  auto view = registry.view<transform, renderable, sorteable>();
+  auto& bulk = compositor.staging();
+  bulk.clear();
+
+  auto& d = registry.ctx().get<dirtable>();
+  auto& ls = registry.ctx().get<layers>();
+  const auto& camera = registry.ctx().get<::camera>();
+
+  if (d.is(dirtable::layout)) {
+    arrange(registry, ls);
+    d.clear(dirtable::layout);
+  }
+
+  for (auto& l : ls.entries) {
+    if (l.dirty) bake(registry, atlasregistry, compositor, l);
+  }
+
+  if (auto* tm = registry.ctx().find<tilemap>())
+    tm->draw(atlasregistry, compositor, camera);
+
+  // Bounds are recomputed only for objects moved, scaled, turned or re-framed since the last frame.
+  for (auto&& [entity, t, r, b] : registry.view<moved, transform, renderable, bounded>().each()) {
+    const auto& a = atlasregistry.at(r.atlas);
+    const auto [hw, hh] = extent(a.sprites()[a.keyframe(r.animation, r.current_frame)], t);
+    b = {hw, hh};
+  }
+
+  registry.clear<moved>();
+
+  auto view = registry.view<transform, renderable, sorteable, bounded>();
   view.use<sorteable>();
 
-  for (auto&& [entity, t, r, s] : view.each()) {
+  // Emitters come out in the same depth order and are merged in ahead of the first object drawn above them.
+  auto emitters = registry.view<emissive, sorteable>();
+  emitters.use<sorteable>();
+  auto emitter = emitters.begin();
+  const auto world = camera.project(1.0f);
+
+  const auto layered = !ls.entries.empty();
+  auto blitted = std::numeric_limits<uint32_t>::max();
+
+  uint32_t culled = 0;
+  atlas* current = nullptr;
+
+  for (auto&& [entity, t, r, s, b] : view.each()) {
+    for (; emitter != emitters.end() && emitters.get<sorteable>(*emitter).z < s.z; ++emitter) {
+      if (current) compositor.submit(*current, bulk);
+      bulk.clear();
+      current = nullptr;
+
+      particlesystem::draw(emitters.get<emissive>(*emitter), atlasregistry, compositor, world);
+    }
+
+    if (layered) {
+      if (const auto* st = registry.try_get<stationary>(entity)) {
+        const auto& l = ls.entries[st->layer];
+        if (l.cached) {
+          if (st->layer != blitted && l.texture) {
+            blitted = st->layer;
+
+            const auto p = camera.project(l.parallax);
+            const SDL_FRect b{p.sx(l.bounds.x), p.sy(l.bounds.y), l.bounds.w * p.zoom, l.bounds.h * p.zoom};
+            if (visible(b.x + b.w * .5f, b.y + b.h * .5f, b.w * .5f, b.h * .5f)) {
+              if (current) compositor.submit(*current, bulk);
+              bulk.clear();
+              current = nullptr;
+
+              compositor.blit(l.texture.get(), b);
+            } else {
+              ++culled;
+            }
+          }
+
+          continue;
+        }
+      }
+    }
+
     if (!t.shown) [[unlikely]] continue;
 
-    auto& a = atlasregistry.get(r.atlas);
-    const auto& kf = a.keyframe_at(r.entry, r.current_frame);
-
-    compositor.push(
-      a,
-      kf.sprite,
-      t.x,
-      t.y,
-      t.scale,
-      lcos(t.angle),
-      lsin(t.angle),
+    const auto p = camera.project(t.parallax);
+    const auto x = p.sx(t.x);
+    const auto y = p.sy(t.y);
+
+    if (!visible(x, y, b.hw * p.zoom, b.hh * p.zoom)) {
+      ++culled;
+      continue;
+    }
+
+    auto& a = atlasregistry.at(r.atlas);
+    const auto& sprite = a.sprites()[a.keyframe(r.animation, r.current_frame)];
+
+    if (&a != current) {
+      if (current) compositor.submit(*current, bulk);
+      bulk.clear();
+      atlasregistry.require(a);
+      current = &a;
+    }
+
+    const auto rotated = t.angle != .0f;
+    bulk.push(
+      sprite,
+      x,
+      y,
+      t.scale * p.zoom,
+      rotated ? lcos(t.angle) : 1.0f,
+      rotated ? lsin(t.angle) : .0f,
       t.alpha
     );
   }
+
+  if (current) compositor.submit(*current, bulk);
+  bulk.clear();
+
+  for (; emitter != emitters.end(); ++emitter)
+    particlesystem::draw(emitters.get<emissive>(*emitter), atlasregistry, compositor, world);
+
+  typesetter::draw(registry, atlasregistry, compositor);
+
+  compositor.cull(culled);
 }
@@ -0,0 +1,242 @@
+#include "recorder.hpp"
+
+namespace {
+  // File layout: the magic, then one record per frame until the end of the file. A record is the
+  // frame's delta, a byte of flags saying what changed since the previous frame, and only those
+  // parts; an idle frame costs five bytes.
+  //
+  //   keys:    u8 count, then count u16 scancodes that toggled
+  //   mouse:   f32 x, f32 y, u32 buttons
+  //   gamepad: u8 connected, i16 axes[SDL_GAMEPAD_AXIS_COUNT], u32 buttons
+  //   stage:   u8 length, then the name of the stage the frame ended on
+  constexpr std::array<uint8_t, 4> magic{'P', 'I', 'R', '1'};
+
+  constexpr uint8_t keys_changed = 1 << 0;
+  constexpr uint8_t mouse_changed = 1 << 1;
+  constexpr uint8_t gamepad_changed = 1 << 2;
+  constexpr uint8_t stage_changed = 1 << 3;
+
+  // Records reach the disk at least this often, so a crashed session loses no more than a second or so of them.
+  constexpr uint64_t flush_interval = 60;
+
+  template <typename T>
+  void put(std::vector<uint8_t>& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <typename T>
+  T take(std::span<const uint8_t>& in) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (in.size() < sizeof(T)) [[unlikely]]
+      throw std::runtime_error("[recorder] recording is truncated");
+
+    T value;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in = in.subspan(sizeof(T));
+    return value;
+  }
+
+  bool skip(std::span<const uint8_t>& in, size_t size) {
+    if (in.size() < size) return false;
+    in = in.subspan(size);
+    return true;
+  }
+
+  // Whether the tape holds all of its next record; a session that died mid-write leaves a partial one at the end.
+  bool whole(std::span<const uint8_t> in) {
+    if (in.size() < sizeof(float) + 1) return false;
+
+    const auto flags = in[sizeof(float)];
+    in = in.subspan(sizeof(float) + 1);
+
+    if (flags & keys_changed) {
+      if (in.empty() || !skip(in, 1 + in.front() * sizeof(uint16_t))) return false;
+    }
+
+    if (flags & mouse_changed) {
+      if (!skip(in, sizeof(float) * 2 + sizeof(uint32_t))) return false;
+    }
+
+    if (flags & gamepad_changed) {
+      if (!skip(in, sizeof(uint8_t) + sizeof(input.axes) + sizeof(uint32_t))) return false;
+    }
+
+    if (flags & stage_changed) {
+      if (in.empty() || !skip(in, 1 + in.front())) return false;
+    }
+
+    return true;
+  }
+
+  void sample(struct input& in) {
+    keyboard::sample(in);
+    mouse::sample(in);
+    gamepad::sample(in);
+  }
+}
+
+recorder::recorder() {
+  if (const auto* const path = std::getenv("REPLAY")) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) [[unlikely]]
+      throw std::runtime_error(std::format("[recorder] cannot open {}", path));
+
+    _buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    _tape = _buffer;
+
+    if (take<std::array<uint8_t, 4>>(_tape) != magic) [[unlikely]]
+      throw std::runtime_error(std::format("[recorder] {} is not a recording", path));
+
+    _mode = mode::replay;
+    return;
+  }
+
+  if (const auto* const path = std::getenv("RECORD")) {
+    _file.open(path, std::ios::binary | std::ios::trunc);
+    if (!_file) [[unlikely]]
+      throw std::runtime_error(std::format("[recorder] cannot create {}", path));
+
+    _file.write(reinterpret_cast<const char*>(magic.data()), magic.size());
+    _mode = mode::record;
+  }
+}
+
+recorder::~recorder() noexcept {
+  if (_mode != mode::replay || _frame == 0) return;
+
+  const auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - _start) / static_cast<double>(SDL_GetPerformanceFrequency());
+  std::println("replayed {} frames in {:.3f}s, {:.3f}ms per frame", _frame, elapsed, elapsed * 1000.0 / static_cast<double>(_frame));
+}
+
+bool recorder::advance(float& delta) {
+  switch (_mode) {
+    case mode::live:
+      sample(input);
+      return true;
+
+    case mode::record: {
+      sample(input);
+
+      _buffer.clear();
+      put(_buffer, delta);
+      const auto at = _buffer.size();
+      put(_buffer, uint8_t{});
+
+      uint8_t flags{};
+
+      std::array<uint16_t, std::numeric_limits<uint8_t>::max()> toggled;
+      size_t count = 0;
+      for (size_t word = 0; word < input.keys.size(); ++word) {
+        for (auto bits = input.keys[word] ^ _previous.keys[word]; bits != 0; bits &= bits - 1) {
+          assert(count < toggled.size() && "too many keys toggled in one frame");
+          toggled[count++] = static_cast<uint16_t>(word * 64 + static_cast<size_t>(std::countr_zero(bits)));
+        }
+      }
+
+      if (count != 0) {
+        flags |= keys_changed;
+        put(_buffer, static_cast<uint8_t>(count));
+        for (size_t i = 0; i < count; ++i) put(_buffer, toggled[i]);
+      }
+
+      if (input.x != _previous.x || input.y != _previous.y || input.buttons != _previous.buttons) {
+        flags |= mouse_changed;
+        put(_buffer, input.x);
+        put(_buffer, input.y);
+        put(_buffer, input.buttons);
+      }
+
+      if (input.connected != _previous.connected || input.axes != _previous.axes || input.pad != _previous.pad) {
+        flags |= gamepad_changed;
+        put(_buffer, static_cast<uint8_t>(input.connected));
+        put(_buffer, input.axes);
+        put(_buffer, input.pad);
+      }
+
+      _buffer[at] = flags;
+      _previous = input;
+      return true;
+    }
+
+    case mode::replay: {
+      // A partial last record ends the tape like the end of the file does.
+      if (!whole(_tape)) {
+        if (!_tape.empty()) std::println("[recorder] dropped a partial frame at the end of the recording");
+        _tape = {};
+        return false;
+      }
+
+      if (_frame == 0) _start = SDL_GetPerformanceCounter();
+
+      delta = take<float>(_tape);
+      const auto flags = take<uint8_t>(_tape);
+
+      if (flags & keys_changed) {
+        const auto count = take<uint8_t>(_tape);
+        for (uint8_t i = 0; i < count; ++i) {
+          const auto code = take<uint16_t>(_tape);
+          input.keys[code / 64] ^= uint64_t{1} << (code % 64);
+        }
+      }
+
+      if (flags & mouse_changed) {
+        input.x = take<float>(_tape);
+        input.y = take<float>(_tape);
+        input.buttons = take<uint32_t>(_tape);
+      }
+
+      if (flags & gamepad_changed) {
+        input.connected = take<uint8_t>(_tape) != 0;
+        input.axes = take<decltype(input.axes)>(_tape);
+        input.pad = take<uint32_t>(_tape);
+      }
+
+      // The stage part follows the input and is read back in track, once the frame has run.
+      _buffer.assign(1, flags);
+      return true;
+    }
+  }
+
+  return true;
+}
+
+void recorder::track(std::string_view current) {
+  switch (_mode) {
+    case mode::live:
+      return;
+
+    case mode::record: {
+      if (current != _stage) {
+        assert(current.size() <= std::numeric_limits<uint8_t>::max() && "stage name too long to record");
+        _stage = current;
+        _buffer[sizeof(float)] |= stage_changed;
+        put(_buffer, static_cast<uint8_t>(_stage.size()));
+        _buffer.insert(_buffer.end(), _stage.begin(), _stage.end());
+      }
+
+      _file.write(reinterpret_cast<const char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+      if (++_frame % flush_interval == 0) _file.flush();
+      return;
+    }
+
+    case mode::replay: {
+      if (_buffer.front() & stage_changed) {
+        const auto length = take<uint8_t>(_tape);
+        if (_tape.size() < length) [[unlikely]]
+          throw std::runtime_error("[recorder] recording is truncated");
+
+        _stage.assign(reinterpret_cast<const char*>(_tape.data()), length);
+        _tape = _tape.subspan(length);
+      }
+
+      // A stage switch the recording does not have, or lacks one it has, means the session diverged.
+      if (current != _stage) [[unlikely]]
+        throw std::runtime_error(std::format("[recorder] replay diverged at frame {}: expected stage {}, got {}", _frame, _stage, current));
+
+      ++_frame;
+      return;
+    }
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common.hpp"
+
+// Records every frame's input, delta and stage to the file named by RECORD, or plays back the file
+// named by REPLAY in place of the devices and the clock, so a session runs the same on any build.
+class recorder final {
+public:
+  recorder();
+  ~recorder() noexcept;
+
+  // Fills the frame's input and returns the delta to step with; false once a replay has run out.
+  [[nodiscard]] bool advance(float& delta);
+
+  // Called after the frame's update; records the stage, or checks it against the recording.
+  void track(std::string_view stage);
+
+private:
+  enum class mode : uint8_t {
+    live,
+    record,
+    replay,
+  };
+
+  mode _mode{mode::live};
+  std::ofstream _file;
+  std::vector<uint8_t> _buffer;
+  std::span<const uint8_t> _tape;
+  struct input _previous{};
+  std::string _stage;
+  uint64_t _frame{};
+  uint64_t _start{};
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "common.hpp"
+
+// Fields of an object's Lua table that snapshots carry, as declared by snapshot = { ... } in its object file.
+struct rememberable final {
+  int table{LUA_NOREF};
+  std::vector<std::string> fields;
+};
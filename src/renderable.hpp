@@ -4,8 +4,8 @@
 
 struct mapping final {
   entt::id_type name{};
-  entt::id_type atlas{};
-  entt::id_type entry{};
+  uint32_t atlas{};
+  uint32_t animation{};
 };
 
 static_assert(std::is_trivially_copyable_v<mapping>);
@@ -18,10 +18,37 @@ struct mappable final {
 static_assert(std::is_trivially_copyable_v<mappable>);
 
 struct renderable final {
-  entt::id_type atlas{};
-  entt::id_type entry{};
-  float counter{};
+  uint32_t atlas{};
+  uint32_t animation{};
   uint32_t current_frame{};
+  uint32_t stamp{};
 };
 
 static_assert(std::is_trivially_copyable_v<renderable>);
+
+// Half extents of the current keyframe under the object's scale and angle, in world units, for culling.
+struct bounded final {
+  float hw{};
+  float hh{};
+};
+
+static_assert(std::is_trivially_copyable_v<bounded>);
+
+// Tags an object whose bounds lag behind its transform or keyframe; presenter::render refreshes and clears it.
+struct moved final {};
+
+// Pending frame changes kept as a min-heap on due, in microseconds; a cue whose stamp no longer
+// matches its renderable was superseded by a later schedule and is dropped when it surfaces.
+struct timeline final {
+  struct cue final {
+    uint64_t due;
+    entt::entity entity;
+    uint32_t stamp;
+  };
+
+  uint64_t now{};
+  std::vector<cue> heap;
+
+  // Animations that ended during the current update, dispatched once the pass is over.
+  std::vector<std::pair<entt::entity, entt::id_type>> ended;
+};
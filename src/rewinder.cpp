@@ -0,0 +1,224 @@
+#include "rewinder.hpp"
+
+namespace {
+  // Handles are unique across stages, so a handle taken on one stage never restores another.
+  uint32_t sequence = 0;
+
+  enum class tag : uint8_t {
+    other,
+    nil,
+    number,
+    boolean,
+    string,
+  };
+
+  template <typename T>
+  void put(std::vector<uint8_t>& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <typename T>
+  T take(std::span<const uint8_t>& in) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    assert(in.size() >= sizeof(T) && "snapshot is truncated");
+    T value;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in = in.subspan(sizeof(T));
+    return value;
+  }
+
+  // Only primitive values are carried; anything else is recorded as other and left untouched on restore.
+  void capture_field(std::vector<uint8_t>& out) {
+    switch (lua_type(L, -1)) {
+      case LUA_TNIL:
+        put(out, tag::nil);
+        break;
+
+      case LUA_TNUMBER:
+        put(out, tag::number);
+        put(out, lua_tonumber(L, -1));
+        break;
+
+      case LUA_TBOOLEAN:
+        put(out, tag::boolean);
+        put(out, static_cast<uint8_t>(lua_toboolean(L, -1)));
+        break;
+
+      case LUA_TSTRING: {
+        size_t length;
+        const auto* value = lua_tolstring(L, -1, &length);
+        put(out, tag::string);
+        put(out, static_cast<uint32_t>(length));
+        out.insert(out.end(), value, value + length);
+        break;
+      }
+
+      default:
+        put(out, tag::other);
+        break;
+    }
+  }
+
+  // Pushes the recorded value, or returns false when the field should be left as it is.
+  bool restore_field(std::span<const uint8_t>& in) {
+    switch (take<tag>(in)) {
+      case tag::nil:
+        lua_pushnil(L);
+        return true;
+
+      case tag::number:
+        lua_pushnumber(L, take<lua_Number>(in));
+        return true;
+
+      case tag::boolean:
+        lua_pushboolean(L, take<uint8_t>(in));
+        return true;
+
+      case tag::string: {
+        const auto length = take<uint32_t>(in);
+        lua_pushlstring(L, reinterpret_cast<const char*>(in.data()), length);
+        in = in.subspan(length);
+        return true;
+      }
+
+      default:
+        return false;
+    }
+  }
+}
+
+uint32_t rewinder::capture(const entt::registry& registry) {
+  const auto handle = ++sequence;
+  auto& s = _slots[handle % capacity];
+  s.handle = handle;
+
+  // The buffer keeps its capacity from the last lap of the ring, so steady capturing does not allocate.
+  auto& out = s.bytes;
+  out.clear();
+
+  const auto& c = registry.ctx().get<camera>();
+  put(out, c.x);
+  put(out, c.y);
+  put(out, c.zoom);
+
+  const auto at = out.size();
+  put(out, uint32_t{});
+
+  uint32_t count = 0;
+  for (auto&& [entity, t, r, z] : registry.view<transform, renderable, sorteable>().each()) {
+    put(out, entt::to_integral(entity));
+    put(out, t);
+    put(out, r);
+    put(out, z);
+
+    const auto* col = registry.try_get<collidable>(entity);
+    const auto body = col && b2Body_IsValid(col->body);
+    put(out, static_cast<uint8_t>(body));
+    if (body) {
+      put(out, b2Body_GetLinearVelocity(col->body));
+      put(out, b2Body_GetAngularVelocity(col->body));
+    }
+
+    const auto* m = registry.try_get<rememberable>(entity);
+    const auto fields = m ? static_cast<uint8_t>(m->fields.size()) : uint8_t{};
+    put(out, fields);
+    if (fields != 0) {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, m->table);
+      for (const auto& field : m->fields) {
+        lua_getfield(L, -1, field.c_str());
+        capture_field(out);
+        lua_pop(L, 1);
+      }
+      lua_pop(L, 1);
+    }
+
+    ++count;
+  }
+
+  std::memcpy(out.data() + at, &count, sizeof(count));
+  return handle;
+}
+
+bool rewinder::restore(entt::registry& registry, atlasregistry& atlasregistry, uint32_t handle) {
+  const auto& s = _slots[handle % capacity];
+  if (handle == 0 || s.handle != handle) return false;
+
+  std::span<const uint8_t> in = s.bytes;
+
+  auto& c = registry.ctx().get<camera>();
+  c.x = take<float>(in);
+  c.y = take<float>(in);
+  c.zoom = take<float>(in);
+
+  auto& d = registry.ctx().get<dirtable>();
+  auto& ls = registry.ctx().get<layers>();
+
+  const auto count = take<uint32_t>(in);
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto entity = static_cast<entt::entity>(take<entt::id_type>(in));
+    const auto t = take<transform>(in);
+    const auto r = take<renderable>(in);
+    const auto z = take<sorteable>(in);
+
+    const auto body = take<uint8_t>(in) != 0;
+    b2Vec2 linear{};
+    float angular{};
+    if (body) {
+      linear = take<b2Vec2>(in);
+      angular = take<float>(in);
+    }
+
+    const auto fields = take<uint8_t>(in);
+    const auto alive = registry.valid(entity);
+
+    if (fields != 0) {
+      const auto* m = alive ? registry.try_get<rememberable>(entity) : nullptr;
+      if (m) lua_rawgeti(L, LUA_REGISTRYINDEX, m->table);
+
+      for (uint8_t f = 0; f < fields; ++f) {
+        if (!restore_field(in)) continue;
+
+        if (m && f < m->fields.size()) {
+          lua_setfield(L, -2, m->fields[f].c_str());
+        } else {
+          lua_pop(L, 1);
+        }
+      }
+
+      if (m) lua_pop(L, 1);
+    }
+
+    if (!alive) continue;
+
+    registry.get<transform>(entity) = t;
+    registry.emplace_or_replace<moved>(entity);
+
+    // The stamp moves forward rather than back, so no cue left over from before the snapshot can match.
+    auto& current = registry.get<renderable>(entity);
+    const auto stamp = current.stamp;
+    current = r;
+    current.stamp = stamp;
+    animator::schedule(registry, atlasregistry, entity);
+
+    auto& depth = registry.get<sorteable>(entity);
+    if (depth.z != z.z) {
+      depth = z;
+      d.mark(dirtable::sort);
+    }
+
+    ls.touch(registry, entity);
+
+    if (auto* col = registry.try_get<collidable>(entity)) {
+      registry.emplace_or_replace<displaced>(entity);
+
+      if (body && b2Body_IsValid(col->body)) {
+        b2Body_SetLinearVelocity(col->body, linear);
+        b2Body_SetAngularVelocity(col->body, angular);
+      }
+    }
+  }
+
+  return true;
+}
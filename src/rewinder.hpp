@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.hpp"
+
+class atlasregistry;
+
+// Ring of compact binary stage snapshots for rewind and rollback. A snapshot holds the camera and,
+// per object, its transform, renderable, depth, body velocity and remembered Lua fields. Restoring
+// one writes that state back onto the objects that still exist; objects destroyed since are not
+// brought back and objects created since are left alone.
+class rewinder final {
+public:
+  static constexpr uint32_t capacity = 120;
+
+  [[nodiscard]] uint32_t capture(const entt::registry& registry);
+  bool restore(entt::registry& registry, atlasregistry& atlasregistry, uint32_t handle);
+
+private:
+  struct slot final {
+    uint32_t handle{};
+    std::vector<uint8_t> bytes;
+  };
+
+  std::array<slot, capacity> _slots;
+};
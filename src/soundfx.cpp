@@ -1,9 +1,14 @@
 #include "soundfx.hpp"
 
-soundfx::soundfx(std::string_view filename) {
-  int channels = 0;
+soundfx::soundfx(std::string_view filename, bool stream) {
+  ma_data_source* source = &_buffer;
+
+  if (stream) {
+    _stream = std::make_unique<opusstream>(filename);
+    source = _stream->source();
+  } else {
+    int channels = 0;
 
-  {
     const auto buffer = io::read(filename);
 
     auto error = 0;
@@ -56,7 +61,7 @@ soundfx::soundfx(std::string_view filename) {
 
   ma_sound_init_from_data_source(
     audioengine,
-    &_buffer,
+    source,
     MA_SOUND_FLAG_NO_SPATIALIZATION | MA_SOUND_FLAG_NO_PITCH,
     nullptr,
     &_sound
@@ -69,7 +74,7 @@ soundfx::soundfx(std::string_view filename) {
 
 soundfx::~soundfx() {
   ma_sound_uninit(&_sound);
-  ma_audio_buffer_uninit(&_buffer);
+  if (!_stream) ma_audio_buffer_uninit(&_buffer);
 }
 
 void soundfx::play() {
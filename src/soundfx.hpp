@@ -2,9 +2,12 @@
 
 #include "common.hpp"
 
+class opusstream;
+
 class soundfx final {
 public:
-  explicit soundfx(std::string_view filename);
+  // Streamed sounds stay compressed and decode while playing; the rest are decoded up front.
+  soundfx(std::string_view filename, bool stream);
   ~soundfx();
 
   soundfx(const soundfx&) = delete;
@@ -26,6 +29,7 @@ public:
 
 private:
   ma_audio_buffer _buffer{};
+  std::unique_ptr<opusstream> _stream;
   ma_sound _sound{};
   std::atomic<bool> _ended{false};
   bool _started{false};
@@ -5,8 +5,13 @@ soundfx& soundregistry::get_or_load(std::string_view name) {
   if (it != _sounds.end())
     return *it->second;
 
-  auto filepath = std::format("blobs/sounds/{}.opus", name);
-  auto sound = std::make_unique<soundfx>(filepath);
+  // Music and long ambience go in blobs/music and are streamed; short effects in blobs/sounds are decoded once.
+  auto filepath = std::format("blobs/music/{}.opus", name);
+  const auto stream = io::exists(filepath);
+  if (!stream)
+    filepath = std::format("blobs/sounds/{}.opus", name);
+
+  auto sound = std::make_unique<soundfx>(filepath, stream);
   auto& reference = *sound;
   _sounds.emplace(std::filesystem::path{filepath}.stem().string(), std::move(sound));
   return reference;
@@ -9,10 +9,40 @@ namespace {
   bool by_depth(const sorteable& a, const sorteable& b) {
     return a.z < b.z;
   }
+
+  uint64_t pack(uint32_t high, uint32_t low) noexcept {
+    return static_cast<uint64_t>(high) << 32 | low;
+  }
+
+  uint64_t pack(b2ShapeId sensor, b2ShapeId visitor) noexcept {
+    return pack(static_cast<uint32_t>(sensor.index1), static_cast<uint32_t>(visitor.index1));
+  }
+
+  void dispatch_collision(entt::registry& registry, entt::entity a, entt::entity b, bool began) {
+    const auto& s_a = registry.get<scriptable>(a);
+    const auto callback = began ? s_a.on_collision : s_a.on_collision_end;
+    if (callback == LUA_NOREF) return;
+
+    const auto& id_b = registry.get<identifiable>(b);
+    const auto& lu = registry.ctx().get<lookupable>();
+
+    const auto& name_b = lu.names.at(id_b.name);
+    const auto& kind_b = lu.names.at(id_b.kind);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, callback);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, s_a.self_ref);
+    lua_pushstring(L, name_b.c_str());
+    lua_pushstring(L, kind_b.c_str());
+    if (lua_pcall(L, 3, 0, 0) != 0) {
+      std::string error = lua_tostring(L, -1);
+      lua_pop(L, 1);
+      throw std::runtime_error(error);
+    }
+  }
 }
 
-stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& compositor, soundregistry& soundregistry)
-    : _atlasregistry(atlasregistry), _compositor(compositor), _soundregistry(soundregistry) {
+stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& compositor, soundregistry& soundregistry, collision collision)
+    : _atlasregistry(atlasregistry), _compositor(compositor), _soundregistry(soundregistry), _collision(collision) {
   b2WorldDef def = b2DefaultWorldDef();
   def.gravity = {.0f, .0f};
   _world = b2CreateWorld(&def);
@@ -20,6 +50,10 @@ stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& co
   object::setup(_registry);
   _registry.ctx().emplace<lookupable>();
   _registry.ctx().emplace<dirtable>();
+  _registry.ctx().emplace<layers>();
+  _registry.ctx().emplace<timeline>();
+  _registry.ctx().emplace<categories>();
+  _registry.ctx().emplace<camera>();
 
   compat_pushglobaltable(L);
   _G = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -40,6 +74,15 @@ stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& co
   lua_pop(L, 1);
 
   soundsystem::wire();
+  camera::wire();
+
+  lua_rawgeti(L, LUA_REGISTRYINDEX, _pool);
+  auto* memory = lua_newuserdata(L, sizeof(cameraproxy));
+  new (memory) cameraproxy{&_registry};
+  luaL_getmetatable(L, "Camera");
+  lua_setmetatable(L, -2);
+  lua_setfield(L, -2, "camera");
+  lua_pop(L, 1);
 
   const auto filename = std::format("stages/{}.lua", name);
   const auto buffer = io::read(filename);
@@ -80,6 +123,127 @@ stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& co
   }
   lua_pop(L, 1);
 
+  lua_getfield(L, -1, "tilemap");
+  if (lua_istable(L, -1)) {
+    tilemap::wire();
+    const auto& tm = _registry.ctx().emplace<tilemap>(tilemap{_registry, _atlasregistry, _world});
+    _atlases.push_back(tm.atlas_index());
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, _pool);
+    auto* memory = lua_newuserdata(L, sizeof(tilemapproxy));
+    new (memory) tilemapproxy{&_registry};
+    luaL_getmetatable(L, "Tilemap");
+    lua_setmetatable(L, -2);
+    lua_setfield(L, -2, "tilemap");
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "emitters");
+  if (lua_istable(L, -1)) {
+    particlesystem::wire();
+
+    const auto count = static_cast<int>(lua_objlen(L, -1));
+    for (int i = 1; i <= count; ++i) {
+      lua_rawgeti(L, -1, i);
+      assert(lua_istable(L, -1) && "emitter entry must be a table");
+
+      lua_getfield(L, -1, "kind");
+      const std::string_view kind = luaL_checkstring(L, -1);
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "name");
+      const std::string_view entry_name = luaL_checkstring(L, -1);
+      lua_pop(L, 1);
+
+      float x = 0, y = 0;
+
+      lua_getfield(L, -1, "x");
+      if (lua_isnumber(L, -1)) x = static_cast<float>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "y");
+      if (lua_isnumber(L, -1)) y = static_cast<float>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      const auto entity = particlesystem::create(_registry, _atlasregistry, kind, x, y);
+
+      lua_getfield(L, -1, "active");
+      if (lua_isboolean(L, -1)) _registry.get<emissive>(entity).active = lua_toboolean(L, -1) != 0;
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "z");
+      if (lua_isnumber(L, -1)) _registry.get<sorteable>(entity).z = static_cast<int16_t>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      const auto index = _registry.get<emissive>(entity).atlas;
+      if (std::ranges::find(_atlases, index) == _atlases.end())
+        _atlases.push_back(index);
+
+      lua_rawgeti(L, LUA_REGISTRYINDEX, _pool);
+      auto* memory = lua_newuserdata(L, sizeof(emitterproxy));
+      new (memory) emitterproxy{&_registry, entity};
+      luaL_getmetatable(L, "Emitter");
+      lua_setmetatable(L, -2);
+      lua_setfield(L, -2, entry_name.data());
+      lua_pop(L, 1);
+
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "texts");
+  if (lua_istable(L, -1)) {
+    typesetter::wire();
+
+    const auto count = static_cast<int>(lua_objlen(L, -1));
+    for (int i = 1; i <= count; ++i) {
+      lua_rawgeti(L, -1, i);
+      assert(lua_istable(L, -1) && "text entry must be a table");
+
+      lua_getfield(L, -1, "font");
+      const std::string_view face = luaL_checkstring(L, -1);
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "name");
+      const std::string_view entry_name = luaL_checkstring(L, -1);
+      lua_pop(L, 1);
+
+      std::string_view content{};
+      lua_getfield(L, -1, "text");
+      if (lua_isstring(L, -1)) content = lua_tostring(L, -1);
+      lua_pop(L, 1);
+
+      float x = 0, y = 0;
+
+      lua_getfield(L, -1, "x");
+      if (lua_isnumber(L, -1)) x = static_cast<float>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "y");
+      if (lua_isnumber(L, -1)) y = static_cast<float>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      const auto entity = typesetter::create(_registry, _atlasregistry, face, content, x, y);
+
+      const auto index = _registry.ctx().get<fonts>().entries[_registry.get<legible>(entity).face].atlas;
+      if (std::ranges::find(_atlases, index) == _atlases.end())
+        _atlases.push_back(index);
+
+      lua_rawgeti(L, LUA_REGISTRYINDEX, _pool);
+      auto* memory = lua_newuserdata(L, sizeof(textproxy));
+      new (memory) textproxy{&_registry, entity};
+      luaL_getmetatable(L, "Text");
+      lua_setmetatable(L, -2);
+      lua_setfield(L, -2, entry_name.data());
+      lua_pop(L, 1);
+
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+
   lua_getfield(L, -1, "objects");
   if (lua_istable(L, -1)) {
     const auto count = static_cast<int>(lua_objlen(L, -1));
@@ -110,14 +274,76 @@ stage::stage(std::string_view name, atlasregistry& atlasregistry, compositor& co
       if (lua_isstring(L, -1)) animation = lua_tostring(L, -1);
       lua_pop(L, 1);
 
-      object::create(*this, _next_z++, entry_name, kind, x, y, animation);
+      auto still = false;
+      lua_getfield(L, -1, "static");
+      if (lua_isboolean(L, -1)) still = lua_toboolean(L, -1) != 0;
+      lua_pop(L, 1);
+
+      std::string_view body{};
+      lua_getfield(L, -1, "body");
+      if (lua_isstring(L, -1)) body = lua_tostring(L, -1);
+      lua_pop(L, 1);
+
+      object::create(*this, _next_z++, entry_name, kind, x, y, animation, still, body);
 
       lua_pop(L, 1);
     }
   }
   lua_pop(L, 1);
 
+  // camera = { x = 0, y = 0, zoom = 2, bounds = { 0, 0, 1280, 720 }, follow = "player" }
+  // Read after the objects so that follow can name one of them.
+  lua_getfield(L, -1, "camera");
+  if (lua_istable(L, -1)) {
+    auto& c = _registry.ctx().get<camera>();
+
+    lua_getfield(L, -1, "x");
+    if (lua_isnumber(L, -1)) c.x = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "y");
+    if (lua_isnumber(L, -1)) c.y = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "zoom");
+    if (lua_isnumber(L, -1)) c.zoom = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+    assert(c.zoom > .0f && "camera zoom must be positive");
+
+    lua_getfield(L, -1, "bounds");
+    if (lua_istable(L, -1)) {
+      SDL_FRect b{};
+      float* const fields[] = {&b.x, &b.y, &b.w, &b.h};
+      for (int i = 0; i < 4; ++i) {
+        lua_rawgeti(L, -1, i + 1);
+        *fields[i] = static_cast<float>(luaL_checknumber(L, -1));
+        lua_pop(L, 1);
+      }
+      c.bounds = b;
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "follow");
+    if (lua_isstring(L, -1)) {
+      const std::string_view target = lua_tostring(L, -1);
+      c.follow(_registry, entt::hashed_string::value(target.data(), target.size()));
+      assert(c.target != entt::null && "camera follows an unknown object");
+    }
+    lua_pop(L, 1);
+
+    c.update(_registry);
+  }
+  lua_pop(L, 1);
+
   _table = luaL_ref(L, LUA_REGISTRYINDEX);
+
+  for (auto&& [entity, m] : _registry.view<mappable>().each()) {
+    for (uint32_t i = 0; i < m.count; ++i) {
+      const auto index = m.mappings[i].atlas;
+      if (std::ranges::find(_atlases, index) == _atlases.end())
+        _atlases.push_back(index);
+    }
+  }
 }
 
 stage::~stage() noexcept {
@@ -153,87 +379,102 @@ void stage::on_enter() {
 void stage::on_loop(float delta) {
   _accumulator += delta;
   while (_accumulator >= fixed_timestep) {
+    if (_collision == collision::overlap) {
+      _overlapper.step(_registry, _atlasregistry);
+
+      for (const auto& [a, b] : _overlapper.ended()) {
+        if (_registry.valid(a) && _registry.valid(b))
+          dispatch_collision(_registry, a, b, false);
+      }
+
+      for (const auto& [a, b] : _overlapper.began()) {
+        if (_registry.valid(a) && _registry.valid(b))
+          dispatch_collision(_registry, a, b, true);
+      }
+
+      _accumulator -= fixed_timestep;
+      continue;
+    }
+
+    object::update(_registry, _atlasregistry);
     b2World_Step(_world, fixed_timestep, world_substeps);
 
     const auto events = b2World_GetSensorEvents(_world);
 
-    for (auto i = 0; i < events.beginCount; ++i) {
-      const auto& e = events.beginEvents[i];
-      assert(b2Shape_IsValid(e.sensorShapeId) && "sensor shape must be valid");
-      assert(b2Shape_IsValid(e.visitorShapeId) && "visitor shape must be valid");
+    // Ends go first: a shape destroyed since the last step may have its slot reused by one that begins now.
+    for (int i = 0; i < events.endCount; ++i) {
+      const auto& e = events.endEvents[i];
 
-      const auto a = static_cast<entt::entity>(reinterpret_cast<std::uintptr_t>(b2Shape_GetUserData(e.sensorShapeId)));
-      const auto b = static_cast<entt::entity>(reinterpret_cast<std::uintptr_t>(b2Shape_GetUserData(e.visitorShapeId)));
+      // Shapes may already be destroyed here, so the pair is recovered from when they began touching.
+      const auto it = _touching.find(pack(e.sensorShapeId, e.visitorShapeId));
+      if (it == _touching.end())
+        continue;
 
-      const auto& id_b = _registry.get<identifiable>(b);
-      const auto& s_a = _registry.get<scriptable>(a);
-      const auto& lu = _registry.ctx().get<lookupable>();
+      const auto pair = it->second;
+      _touching.erase(it);
 
-      const auto& name_b = lu.names.at(id_b.name);
-      const auto& kind_b = lu.names.at(id_b.kind);
+      if (--_overlaps[pair] != 0)
+        continue;
 
-      if (s_a.on_collision != LUA_NOREF) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, s_a.on_collision);
-        lua_rawgeti(L, LUA_REGISTRYINDEX, s_a.self_ref);
-        lua_pushstring(L, name_b.c_str());
-        lua_pushstring(L, kind_b.c_str());
-        if (lua_pcall(L, 3, 0, 0) != 0) {
-          std::string error = lua_tostring(L, -1);
-          lua_pop(L, 1);
-          throw std::runtime_error(error);
-        }
-      }
+      _overlaps.erase(pair);
+
+      const auto a = static_cast<entt::entity>(static_cast<uint32_t>(pair >> 32));
+      const auto b = static_cast<entt::entity>(static_cast<uint32_t>(pair));
+      if (_registry.valid(a) && _registry.valid(b))
+        dispatch_collision(_registry, a, b, false);
     }
 
-    for (int i = 0; i < events.endCount; ++i) {
-      const auto& e = events.endEvents[i];
-      if (!b2Shape_IsValid(e.sensorShapeId) || !b2Shape_IsValid(e.visitorShapeId))
-        continue;
+    for (auto i = 0; i < events.beginCount; ++i) {
+      const auto& e = events.beginEvents[i];
+      assert(b2Shape_IsValid(e.sensorShapeId) && "sensor shape must be valid");
+      assert(b2Shape_IsValid(e.visitorShapeId) && "visitor shape must be valid");
 
       const auto a = static_cast<entt::entity>(reinterpret_cast<std::uintptr_t>(b2Shape_GetUserData(e.sensorShapeId)));
       const auto b = static_cast<entt::entity>(reinterpret_cast<std::uintptr_t>(b2Shape_GetUserData(e.visitorShapeId)));
 
-      const auto& id_b = _registry.get<identifiable>(b);
-      const auto& s_a = _registry.get<scriptable>(a);
-      const auto& lu = _registry.ctx().get<lookupable>();
-
-      const auto& name_b = lu.names.at(id_b.name);
-      const auto& kind_b = lu.names.at(id_b.kind);
-
-      if (s_a.on_collision_end != LUA_NOREF) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, s_a.on_collision_end);
-        lua_rawgeti(L, LUA_REGISTRYINDEX, s_a.self_ref);
-        lua_pushstring(L, name_b.c_str());
-        lua_pushstring(L, kind_b.c_str());
-        if (lua_pcall(L, 3, 0, 0) != 0) {
-          std::string error = lua_tostring(L, -1);
-          lua_pop(L, 1);
-          throw std::runtime_error(error);
-        }
-      }
+      // Objects may carry several shapes; a pair of objects collides once, however many of their shapes overlap.
+      const auto pair = pack(entt::to_integral(a), entt::to_integral(b));
+      _touching[pack(e.sensorShapeId, e.visitorShapeId)] = pair;
+      if (_overlaps[pair]++ == 0)
+        dispatch_collision(_registry, a, b, true);
     }
 
     _accumulator -= fixed_timestep;
   }
 
   animator::update(_registry, _atlasregistry, delta);
-  object::update(_registry, _atlasregistry);
+  particlesystem::update(_registry, delta);
   scripting::update(_registry, delta);
+  object::update(_registry, _atlasregistry);
 
-  for (auto&& [entity, s, c] : _registry.view<scriptable, collidable>().each()) {
+  auto& camera = _registry.ctx().get<::camera>();
+  camera.update(_registry);
+
+  // Bounds come from the keyframe outline, so both collision backends see the same edges, and each object
+  // is tested against the view at its own parallax, as the presenter draws it.
+  for (auto&& [entity, s, t, r] : _registry.view<scriptable, transform, renderable>().each()) {
     if (s.on_screen_exit == LUA_NOREF && s.on_screen_enter == LUA_NOREF)
       continue;
 
-    if (!b2Shape_IsValid(c.shape))
+    if (t.alpha == 0 || !_registry.any_of<collidable, overlappable>(entity))
+      continue;
+
+    auto& a = _atlasregistry.at(r.atlas);
+    const auto outline = a.outline(a.keyframe(r.animation, r.current_frame));
+    if (outline == atlas::none)
       continue;
 
-    const auto aabb = b2Shape_GetAABB(c.shape);
+    auto aabb = a.bounds(outline, t.scale);
+    aabb.lowerBound = b2Add(aabb.lowerBound, {t.x, t.y});
+    aabb.upperBound = b2Add(aabb.upperBound, {t.x, t.y});
+
+    const auto view = camera.visible(t.parallax);
 
     uint8_t current = 0;
-    if (aabb.upperBound.x < 0)               current |= scriptable::screen_left;
-    if (aabb.lowerBound.x > viewport.width)  current |= scriptable::screen_right;
-    if (aabb.upperBound.y < 0)               current |= scriptable::screen_top;
-    if (aabb.lowerBound.y > viewport.height) current |= scriptable::screen_bottom;
+    if (aabb.upperBound.x < view.x)          current |= scriptable::screen_left;
+    if (aabb.lowerBound.x > view.x + view.w) current |= scriptable::screen_right;
+    if (aabb.upperBound.y < view.y)          current |= scriptable::screen_top;
+    if (aabb.lowerBound.y > view.y + view.h) current |= scriptable::screen_bottom;
 
     const auto exited  = static_cast<uint8_t>(current & ~s.screen_previous);
     const auto entered = static_cast<uint8_t>(s.screen_previous & ~current);
@@ -271,6 +512,7 @@ void stage::on_loop(float delta) {
   if (d.is(dirtable::sort)) {
     _registry.sort<sorteable>(by_depth, entt::insertion_sort{});
     d.clear(dirtable::sort);
+    d.mark(dirtable::layout);
   }
 
   soundsystem::dispatch(_pool, _sounds, _soundregistry);
@@ -296,20 +538,33 @@ void stage::on_draw() {
 #ifdef DEVELOPMENT
   SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
 
-  const b2AABB aabb = {{0, 0}, {viewport.width, viewport.height}};
+  const auto view = _registry.ctx().get<camera>().visible();
+  auto p = _registry.ctx().get<camera>().project(1.0f);
+  const b2AABB aabb = {{view.x, view.y}, {view.x + view.w, view.y + view.h}};
   const b2QueryFilter filter = b2DefaultQueryFilter();
 
-  b2World_OverlapAABB(_world, aabb, filter, [](b2ShapeId shape, void*) -> bool {
+  b2World_OverlapAABB(_world, aabb, filter, [](b2ShapeId shape, void* context) -> bool {
+    const auto& p = *static_cast<const projection*>(context);
     const auto box = b2Shape_GetAABB(shape);
     const SDL_FRect r{
-      box.lowerBound.x,
-      box.lowerBound.y,
-      box.upperBound.x - box.lowerBound.x,
-      box.upperBound.y - box.lowerBound.y
+      p.sx(box.lowerBound.x),
+      p.sy(box.lowerBound.y),
+      (box.upperBound.x - box.lowerBound.x) * p.zoom,
+      (box.upperBound.y - box.lowerBound.y) * p.zoom
     };
     SDL_RenderRect(renderer, &r);
     return true;
-  }, nullptr);
+  }, &p);
+
+  for (const auto& box : _overlapper.boxes()) {
+    const SDL_FRect r{
+      p.sx(box.lowerBound.x),
+      p.sy(box.lowerBound.y),
+      (box.upperBound.x - box.lowerBound.x) * p.zoom,
+      (box.upperBound.y - box.lowerBound.y) * p.zoom
+    };
+    SDL_RenderRect(renderer, &r);
+  }
 
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
 #endif
@@ -332,3 +587,15 @@ void stage::on_leave() {
   lua_rawgeti(L, LUA_REGISTRYINDEX, _G);
   compat_replaceglobaltable(L);
 }
+
+uint32_t stage::snapshot() {
+  return _rewinder.capture(_registry);
+}
+
+bool stage::restore(uint32_t handle) {
+  return _rewinder.restore(_registry, _atlasregistry, handle);
+}
+
+std::span<const uint32_t> stage::atlases() const noexcept {
+  return _atlases;
+}
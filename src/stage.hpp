@@ -6,14 +6,14 @@ class soundregistry;
 class stage;
 
 namespace object {
-  void create(stage&, int16_t, std::string_view, std::string_view, float, float, std::string_view);
+  void create(stage&, int16_t, std::string_view, std::string_view, float, float, std::string_view, bool, std::string_view);
 }
 
 class stage final {
-  friend void object::create(stage&, int16_t, std::string_view, std::string_view, float, float, std::string_view);
+  friend void object::create(stage&, int16_t, std::string_view, std::string_view, float, float, std::string_view, bool, std::string_view);
 
 public:
-  stage(std::string_view name, atlasregistry& atlasregistry, compositor& compositor, soundregistry& soundregistry);
+  stage(std::string_view name, atlasregistry& atlasregistry, compositor& compositor, soundregistry& soundregistry, collision collision);
   ~stage() noexcept;
 
   void on_enter();
@@ -24,6 +24,12 @@ public:
 
   void on_leave();
 
+  [[nodiscard]] uint32_t snapshot();
+
+  bool restore(uint32_t handle);
+
+  std::span<const uint32_t> atlases() const noexcept;
+
 private:
   atlasregistry& _atlasregistry;
   compositor& _compositor;
@@ -33,8 +39,14 @@ private:
   int _pool;
   int _table;
   std::vector<std::string> _sounds;
+  std::vector<uint32_t> _atlases;
+  std::unordered_map<uint64_t, uint64_t> _touching;
+  std::unordered_map<uint64_t, uint32_t> _overlaps;
   entt::registry _registry;
   b2WorldId _world;
+  collision _collision;
+  overlapper _overlapper;
+  rewinder _rewinder;
   float _accumulator{};
   int16_t _next_z{};
 };
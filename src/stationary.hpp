@@ -0,0 +1,27 @@
+#pragma once
+
+#include "common.hpp"
+
+struct stationary final {
+  uint32_t layer{};
+};
+
+static_assert(std::is_trivially_copyable_v<stationary>);
+
+struct layer final {
+  std::vector<entt::entity> members;
+  std::unique_ptr<SDL_Texture, SDL_Deleter> texture;
+  SDL_FRect bounds{};
+  float parallax{1.0f};
+  bool dirty{true};
+  bool cached{};
+};
+
+struct layers final {
+  std::vector<layer> entries;
+
+  void touch(const entt::registry& registry, entt::entity entity) noexcept {
+    const auto* s = registry.try_get<stationary>(entity);
+    if (s && s->layer < entries.size()) entries[s->layer].dirty = true;
+  }
+};
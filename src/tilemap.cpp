@@ -0,0 +1,495 @@
+#include "tilemap.hpp"
+
+namespace {
+  // Binary tile layer: "PTL1", width, height, then width * height little-endian uint16 cells in row order.
+  struct header final {
+    std::array<char, 4> magic;
+    uint32_t width;
+    uint32_t height;
+  };
+
+  static_assert(sizeof(header) == 12);
+
+  constexpr std::array<char, 4> signature{'P', 'T', 'L', '1'};
+
+  entt::id_type hash(std::string_view value) {
+    return entt::hashed_string::value(value.data(), value.size());
+  }
+
+  bool visible(const SDL_FRect& r, const projection& p) {
+    return p.sx(r.x + r.w) >= .0f
+        && p.sy(r.y + r.h) >= .0f
+        && p.sx(r.x) <= viewport.width
+        && p.sy(r.y) <= viewport.height;
+  }
+
+  tilemap& resolve(lua_State* state) {
+    auto* proxy = static_cast<tilemapproxy*>(luaL_checkudata(state, 1, "Tilemap"));
+    return proxy->registry->ctx().get<tilemap>();
+  }
+
+  std::tuple<uint32_t, uint32_t, uint32_t> cell(lua_State* state, const tilemap& tm) {
+    const auto layer = static_cast<uint32_t>(luaL_checkinteger(state, 2));
+    const auto x = static_cast<uint32_t>(luaL_checkinteger(state, 3));
+    const auto y = static_cast<uint32_t>(luaL_checkinteger(state, 4));
+
+    luaL_argcheck(state, layer >= 1 && layer <= tm.depth(), 2, "layer out of range");
+    luaL_argcheck(state, x < tm.width(), 3, "x out of range");
+    luaL_argcheck(state, y < tm.height(), 4, "y out of range");
+
+    return {layer - 1, x, y};
+  }
+
+  int tilemap_get(lua_State* state) {
+    const auto& tm = resolve(state);
+    const auto [layer, x, y] = cell(state, tm);
+
+    const auto tile = tm.get(layer, x, y);
+    if (tile == 0) return lua_pushnil(state), 1;
+
+    const auto name = tm.name(tile);
+    lua_pushlstring(state, name.data(), name.size());
+    return 1;
+  }
+
+  int tilemap_set(lua_State* state) {
+    auto& tm = resolve(state);
+    const auto [layer, x, y] = cell(state, tm);
+
+    uint16_t tile = 0;
+    if (!lua_isnoneornil(state, 5)) {
+      tile = tm.find(luaL_checkstring(state, 5));
+      luaL_argcheck(state, tile != 0, 5, "unknown tile");
+    }
+
+    tm.set(layer, x, y, tile);
+    return 0;
+  }
+
+  int tilemap_index(lua_State* state) {
+    const auto& tm = resolve(state);
+    const std::string_view key = luaL_checkstring(state, 2);
+
+    if (key == "width") {
+      lua_pushinteger(state, static_cast<lua_Integer>(tm.width()));
+      return 1;
+    }
+
+    if (key == "height") {
+      lua_pushinteger(state, static_cast<lua_Integer>(tm.height()));
+      return 1;
+    }
+
+    if (key == "get") {
+      lua_pushcfunction(state, tilemap_get);
+      return 1;
+    }
+
+    if (key == "set") {
+      lua_pushcfunction(state, tilemap_set);
+      return 1;
+    }
+
+    return lua_pushnil(state), 1;
+  }
+
+  void init() {
+    luaL_newmetatable(L, "Tilemap");
+
+    lua_pushcfunction(L, tilemap_index);
+    lua_setfield(L, -2, "__index");
+
+    lua_pop(L, 1);
+  }
+}
+
+// Reads the stage's tilemap table from the top of the Lua stack:
+//
+//   tilemap = {
+//     atlas = "dungeon",
+//     size = 16,
+//     tiles = { "floor", "wall", "water" },
+//     solid = { "wall" },
+//     layer = "walls",
+//     collides_with = { "player", "enemy" },
+//     layers = {
+//       { width = 3, height = 2, cells = { 2, 2, 2, 1, 0, 3 } },
+//       { file = "tilemaps/dungeon.tl", parallax = 0.5 },
+//     },
+//   }
+//
+// A cell holds an index into tiles, with 0 left empty; every layer shares the first layer's size.
+// parallax scales how far a layer moves with the camera, 1 by default. Solid tiles sit on the collision
+// layer named by layer, "tilemap" by default, so objects can list it in collides_with; collides_with
+// limits which object layers the tiles meet, all of them by default.
+tilemap::tilemap(entt::registry& registry, atlasregistry& atlasregistry, b2WorldId world) {
+  lua_getfield(L, -1, "atlas");
+  const std::string_view atlas_name = luaL_checkstring(L, -1);
+  _atlas = atlasregistry.resolve(hash(atlas_name));
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "size");
+  _size = static_cast<float>(luaL_checknumber(L, -1));
+  lua_pop(L, 1);
+
+  const auto& a = atlasregistry.at(_atlas);
+
+  _names.emplace_back();
+  _keyframes.push_back(0);
+
+  lua_getfield(L, -1, "tiles");
+  assert(lua_istable(L, -1) && "tilemap must list its tiles");
+  const auto count = static_cast<int>(lua_objlen(L, -1));
+  assert(count < std::numeric_limits<uint16_t>::max() && "too many tiles in tilemap");
+  for (int i = 1; i <= count; ++i) {
+    lua_rawgeti(L, -1, i);
+    const std::string_view tile = luaL_checkstring(L, -1);
+    const auto animation = a.resolve(hash(tile));
+    assert(animation != atlas::none && "tile not found in atlas");
+    _names.emplace_back(tile);
+    _keyframes.push_back(a.keyframe(animation, 0));
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+
+  _solid.assign(_names.size(), false);
+
+  lua_getfield(L, -1, "solid");
+  if (lua_istable(L, -1)) {
+    const auto solids = static_cast<int>(lua_objlen(L, -1));
+    for (int i = 1; i <= solids; ++i) {
+      lua_rawgeti(L, -1, i);
+      const auto tile = find(luaL_checkstring(L, -1));
+      assert(tile != 0 && "solid tile not listed in tiles");
+      _solid[tile] = true;
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "layers");
+  assert(lua_istable(L, -1) && "tilemap must have layers");
+  const auto planes = static_cast<int>(lua_objlen(L, -1));
+  for (int i = 1; i <= planes; ++i) {
+    lua_rawgeti(L, -1, i);
+    assert(lua_istable(L, -1) && "tilemap layer must be a table");
+
+    auto& p = _planes.emplace_back();
+
+    lua_getfield(L, -1, "parallax");
+    if (lua_isnumber(L, -1)) p.parallax = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "file");
+    if (lua_isstring(L, -1)) {
+      read(lua_tostring(L, -1), p);
+      lua_pop(L, 1);
+    } else {
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "width");
+      const auto width = static_cast<uint32_t>(luaL_checkinteger(L, -1));
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "height");
+      const auto height = static_cast<uint32_t>(luaL_checkinteger(L, -1));
+      lua_pop(L, 1);
+
+      if (_planes.size() == 1) {
+        _width = width;
+        _height = height;
+      }
+      assert(width == _width && height == _height && "tilemap layers must share one size");
+
+      p.cells.assign(static_cast<size_t>(_width) * _height, 0);
+
+      lua_getfield(L, -1, "cells");
+      assert(lua_istable(L, -1) && "tilemap layer must have cells or a file");
+      const auto cells = std::min(static_cast<size_t>(lua_objlen(L, -1)), p.cells.size());
+      for (auto c = 0uz; c < cells; ++c) {
+        lua_rawgeti(L, -1, static_cast<int>(c + 1));
+        p.cells[c] = static_cast<uint16_t>(lua_tointeger(L, -1));
+        lua_pop(L, 1);
+      }
+      lua_pop(L, 1);
+    }
+
+    [[maybe_unused]] const auto valid = std::ranges::all_of(p.cells, [&](uint16_t tile) { return tile < _names.size(); });
+    assert(valid && "tilemap cell refers to an unknown tile");
+
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+
+  _columns = (_width + span - 1) / span;
+  _rows = (_height + span - 1) / span;
+
+  for (auto& p : _planes) {
+    p.chunks.resize(static_cast<size_t>(_columns) * _rows);
+  }
+
+  if (std::ranges::find(_solid, true) == _solid.end()) return;
+
+  auto& cs = registry.ctx().get<categories>();
+
+  lua_getfield(L, -1, "layer");
+  _category = cs.bit(hash(lua_isstring(L, -1) ? lua_tostring(L, -1) : "tilemap"));
+  lua_pop(L, 1);
+
+  lua_getfield(L, -1, "collides_with");
+  if (lua_istable(L, -1)) {
+    _mask = 0;
+    const auto count = static_cast<int>(lua_objlen(L, -1));
+    for (int i = 1; i <= count; ++i) {
+      lua_rawgeti(L, -1, i);
+      _mask |= cs.bit(hash(luaL_checkstring(L, -1)));
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+
+  _entity = registry.create();
+  registry.emplace<identifiable>(_entity, hash("tilemap"), hash("tilemap"));
+  registry.ctx().get<lookupable>().names.emplace(hash("tilemap"), "tilemap");
+
+  auto def = b2DefaultBodyDef();
+  def.type = b2_staticBody;
+  def.userData = reinterpret_cast<void*>(static_cast<std::uintptr_t>(_entity));
+  _body = b2CreateBody(world, &def);
+
+  _shapes.resize(static_cast<size_t>(_columns) * _rows);
+  _boxes.resize(static_cast<size_t>(_columns) * _rows);
+  for (auto index = 0u; index < _columns * _rows; ++index) {
+    solidify(index);
+  }
+}
+
+uint32_t tilemap::atlas_index() const noexcept {
+  return _atlas;
+}
+
+uint32_t tilemap::width() const noexcept {
+  return _width;
+}
+
+uint32_t tilemap::height() const noexcept {
+  return _height;
+}
+
+uint32_t tilemap::depth() const noexcept {
+  return static_cast<uint32_t>(_planes.size());
+}
+
+uint16_t tilemap::get(uint32_t layer, uint32_t x, uint32_t y) const noexcept {
+  assert(layer < _planes.size() && x < _width && y < _height && "tile out of bounds");
+  return _planes[layer].cells[static_cast<size_t>(y) * _width + x];
+}
+
+void tilemap::set(uint32_t layer, uint32_t x, uint32_t y, uint16_t tile) {
+  assert(layer < _planes.size() && x < _width && y < _height && "tile out of bounds");
+  assert(tile < _names.size() && "unknown tile");
+
+  auto& current = _planes[layer].cells[static_cast<size_t>(y) * _width + x];
+  if (current == tile) return;
+
+  const auto was = solid(x, y);
+  current = tile;
+
+  const auto index = (y / span) * _columns + x / span;
+  _planes[layer].chunks[index].dirty = true;
+
+  if (b2Body_IsValid(_body) && solid(x, y) != was)
+    solidify(index);
+}
+
+entt::entity tilemap::entity() const noexcept {
+  return _entity;
+}
+
+std::span<const std::vector<b2AABB>> tilemap::solids() const noexcept {
+  return _boxes;
+}
+
+uint64_t tilemap::category() const noexcept {
+  return _category;
+}
+
+uint64_t tilemap::mask() const noexcept {
+  return _mask;
+}
+
+uint16_t tilemap::find(std::string_view name) const noexcept {
+  const auto it = std::ranges::find(_names, name);
+  if (it == _names.end() || it == _names.begin()) return 0;
+  return static_cast<uint16_t>(it - _names.begin());
+}
+
+std::string_view tilemap::name(uint16_t tile) const noexcept {
+  assert(tile < _names.size() && "unknown tile");
+  return _names[tile];
+}
+
+void tilemap::draw(atlasregistry& atlasregistry, compositor& compositor, const camera& camera) {
+  auto& a = atlasregistry.at(_atlas);
+  atlasregistry.require(a);
+
+  uint32_t culled = 0;
+
+  for (auto& p : _planes) {
+    const auto projection = camera.project(p.parallax);
+
+    for (auto index = 0u; index < p.chunks.size(); ++index) {
+      auto& c = p.chunks[index];
+      if (c.dirty) build(a, p, index, c);
+      if (c.positions.empty()) continue;
+
+      if (!visible(c.bounds, projection)) {
+        culled += static_cast<uint32_t>(c.positions.size() / 4);
+        continue;
+      }
+
+      compositor.mesh(a, c.positions, c.uvs, projection, 255);
+    }
+  }
+
+  compositor.cull(culled);
+}
+
+void tilemap::wire() {
+  static std::once_flag once;
+  std::call_once(once, init);
+}
+
+void tilemap::read(std::string_view filename, plane& p) {
+  const auto buffer = io::read(filename);
+
+  header h;
+  if (buffer.size() < sizeof(h)) [[unlikely]]
+    throw std::runtime_error(std::format("tile layer {} is truncated", filename));
+
+  std::memcpy(&h, buffer.data(), sizeof(h));
+  if (h.magic != signature) [[unlikely]]
+    throw std::runtime_error(std::format("tile layer {} has an unknown format", filename));
+
+  const auto cells = static_cast<size_t>(h.width) * h.height;
+  if (buffer.size() != sizeof(h) + cells * sizeof(uint16_t)) [[unlikely]]
+    throw std::runtime_error(std::format("tile layer {} is truncated", filename));
+
+  if (_planes.size() == 1) {
+    _width = h.width;
+    _height = h.height;
+  }
+  assert(h.width == _width && h.height == _height && "tilemap layers must share one size");
+
+  p.cells.resize(cells);
+  std::memcpy(p.cells.data(), buffer.data() + sizeof(h), cells * sizeof(uint16_t));
+}
+
+void tilemap::build(const atlas& a, const plane& p, uint32_t index, chunk& c) const {
+  c.dirty = false;
+  c.positions.clear();
+  c.uvs.clear();
+
+  const auto sprites = a.sprites();
+
+  const auto cx = (index % _columns) * span;
+  const auto cy = (index / _columns) * span;
+  const auto ex = std::min(cx + span, _width);
+  const auto ey = std::min(cy + span, _height);
+
+  auto x0 = std::numeric_limits<float>::max();
+  auto y0 = std::numeric_limits<float>::max();
+  auto x1 = std::numeric_limits<float>::lowest();
+  auto y1 = std::numeric_limits<float>::lowest();
+
+  for (auto y = cy; y < ey; ++y) {
+    for (auto x = cx; x < ex; ++x) {
+      const auto tile = p.cells[static_cast<size_t>(y) * _width + x];
+      if (tile == 0) continue;
+
+      const auto& s = sprites[_keyframes[tile]];
+      const auto left = static_cast<float>(x) * _size;
+      const auto top = static_cast<float>(y) * _size;
+      const auto right = left + s.w;
+      const auto bottom = top + s.h;
+
+      c.positions.push_back({left, top});
+      c.positions.push_back({right, top});
+      c.positions.push_back({right, bottom});
+      c.positions.push_back({left, bottom});
+
+      c.uvs.push_back({s.u0, s.v0});
+      c.uvs.push_back({s.u1, s.v0});
+      c.uvs.push_back({s.u1, s.v1});
+      c.uvs.push_back({s.u0, s.v1});
+
+      x0 = std::min(x0, left);
+      y0 = std::min(y0, top);
+      x1 = std::max(x1, right);
+      y1 = std::max(y1, bottom);
+    }
+  }
+
+  c.bounds = c.positions.empty() ? SDL_FRect{} : SDL_FRect{x0, y0, x1 - x0, y1 - y0};
+}
+
+// Covers the chunk's solid cells with as few boxes as possible: each box grows right, then down, over cells not yet covered.
+void tilemap::solidify(uint32_t index) {
+  for (const auto shape : _shapes[index]) {
+    b2DestroyShape(shape, false);
+  }
+  _shapes[index].clear();
+  _boxes[index].clear();
+
+  const auto cx = (index % _columns) * span;
+  const auto cy = (index / _columns) * span;
+  const auto ex = std::min(cx + span, _width);
+  const auto ey = std::min(cy + span, _height);
+
+  std::array<bool, span * span> covered{};
+  const auto taken = [&](uint32_t x, uint32_t y) -> bool& {
+    return covered[(y - cy) * span + (x - cx)];
+  };
+
+  auto def = b2DefaultShapeDef();
+  def.enableSensorEvents = true;
+  def.filter.categoryBits = _category;
+  def.filter.maskBits = _mask;
+  def.userData = reinterpret_cast<void*>(static_cast<std::uintptr_t>(_entity));
+
+  for (auto y = cy; y < ey; ++y) {
+    for (auto x = cx; x < ex; ++x) {
+      if (taken(x, y) || !solid(x, y)) continue;
+
+      auto right = x + 1;
+      while (right < ex && !taken(right, y) && solid(right, y)) ++right;
+
+      auto bottom = y + 1;
+      while (bottom < ey) {
+        auto row = true;
+        for (auto i = x; i < right && row; ++i) row = !taken(i, bottom) && solid(i, bottom);
+        if (!row) break;
+        ++bottom;
+      }
+
+      for (auto j = y; j < bottom; ++j) {
+        for (auto i = x; i < right; ++i) taken(i, j) = true;
+      }
+
+      const auto hw = static_cast<float>(right - x) * _size * .5f;
+      const auto hh = static_cast<float>(bottom - y) * _size * .5f;
+      const b2Vec2 center{static_cast<float>(x) * _size + hw, static_cast<float>(y) * _size + hh};
+      const auto box = b2MakeOffsetBox(hw, hh, center, b2Rot_identity);
+      _shapes[index].push_back(b2CreatePolygonShape(_body, &def, &box));
+      _boxes[index].push_back({{center.x - hw, center.y - hh}, {center.x + hw, center.y + hh}});
+    }
+  }
+}
+
+bool tilemap::solid(uint32_t x, uint32_t y) const noexcept {
+  const auto offset = static_cast<size_t>(y) * _width + x;
+  for (const auto& p : _planes) {
+    if (_solid[p.cells[offset]]) return true;
+  }
+  return false;
+}
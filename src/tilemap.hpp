@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.hpp"
+
+class atlasregistry;
+class compositor;
+
+struct tilemapproxy final {
+  entt::registry* registry;
+};
+
+// Tiles live outside the ECS: cells are plain arrays split into fixed-size chunks, each chunk keeps
+// its quads prebuilt and is rebuilt only after one of its cells changes.
+class tilemap final {
+public:
+  static constexpr uint32_t span = 32;
+
+  tilemap(entt::registry& registry, atlasregistry& atlasregistry, b2WorldId world);
+  ~tilemap() noexcept = default;
+
+  tilemap(tilemap&&) noexcept = default;
+  tilemap& operator=(tilemap&&) noexcept = default;
+
+  [[nodiscard]] uint32_t atlas_index() const noexcept;
+  [[nodiscard]] uint32_t width() const noexcept;
+  [[nodiscard]] uint32_t height() const noexcept;
+  [[nodiscard]] uint32_t depth() const noexcept;
+
+  [[nodiscard]] uint16_t get(uint32_t layer, uint32_t x, uint32_t y) const noexcept;
+  void set(uint32_t layer, uint32_t x, uint32_t y, uint16_t tile);
+
+  [[nodiscard]] uint16_t find(std::string_view name) const noexcept;
+  [[nodiscard]] std::string_view name(uint16_t tile) const noexcept;
+
+  void draw(atlasregistry& atlasregistry, compositor& compositor, const camera& camera);
+
+  // The entity collisions with solid tiles are reported against; null when no tile is solid.
+  [[nodiscard]] entt::entity entity() const noexcept;
+
+  // Solid tiles merged into boxes, chunk by chunk, in world space; what the overlap backend tests against.
+  [[nodiscard]] std::span<const std::vector<b2AABB>> solids() const noexcept;
+
+  // Collision filter of the solid tiles, named through the stage's categories like an object's.
+  [[nodiscard]] uint64_t category() const noexcept;
+  [[nodiscard]] uint64_t mask() const noexcept;
+
+  static void wire();
+
+private:
+  struct chunk final {
+    std::vector<SDL_FPoint> positions;
+    std::vector<SDL_FPoint> uvs;
+    SDL_FRect bounds{};
+    bool dirty{true};
+  };
+
+  struct plane final {
+    std::vector<uint16_t> cells;
+    std::vector<chunk> chunks;
+    float parallax{1.0f};
+  };
+
+  void read(std::string_view filename, plane& p);
+  void build(const atlas& a, const plane& p, uint32_t index, chunk& c) const;
+  void solidify(uint32_t index);
+  [[nodiscard]] bool solid(uint32_t x, uint32_t y) const noexcept;
+
+  uint32_t _atlas{};
+  float _size{};
+  uint32_t _width{};
+  uint32_t _height{};
+  uint32_t _columns{};
+  uint32_t _rows{};
+  std::vector<std::string> _names;
+  std::vector<uint32_t> _keyframes;
+  std::vector<bool> _solid;
+  std::vector<plane> _planes;
+  std::vector<std::vector<b2ShapeId>> _shapes;
+  std::vector<std::vector<b2AABB>> _boxes;
+  b2BodyId _body{};
+  uint64_t _category{B2_DEFAULT_CATEGORY_BITS};
+  uint64_t _mask{B2_DEFAULT_MASK_BITS};
+  entt::entity _entity{entt::null};
+};
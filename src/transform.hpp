@@ -7,6 +7,7 @@ struct transform final {
   float y{};
   float scale{1.0f};
   float angle{};
+  float parallax{1.0f};
   uint8_t alpha{255};
   bool shown{true};
 };
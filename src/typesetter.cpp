@@ -0,0 +1,252 @@
+#include "typesetter.hpp"
+
+namespace {
+  entt::id_type hash(std::string_view value) {
+    return entt::hashed_string::value(value.data(), value.size());
+  }
+
+  // Loads fonts/<name>.lua once per stage:
+  //
+  //   return { atlas = "hud", prefix = "glyph_", characters = "0123456789:", spacing = 1, space = 4, leading = 2 }
+  //
+  // Each character c is drawn with the atlas entry prefix .. c; characters are single bytes.
+  uint32_t load(entt::registry& registry, atlasregistry& atlasregistry, std::string_view name) {
+    auto& fs = registry.ctx().get<fonts>();
+
+    const auto id = hash(name);
+    if (const auto it = fs.lookup.find(id); it != fs.lookup.end()) return it->second;
+
+    const auto filename = std::format("fonts/{}.lua", name);
+    const auto buffer = io::read(filename);
+    const auto* data = reinterpret_cast<const char*>(buffer.data());
+    const auto size = buffer.size();
+    const auto label = std::format("@{}", filename);
+
+    luaL_loadbuffer(L, data, size, label.c_str());
+    if (lua_pcall(L, 0, 1, 0) != 0) {
+      std::string error = lua_tostring(L, -1);
+      lua_pop(L, 1);
+      throw std::runtime_error(error);
+    }
+
+    assert(lua_istable(L, -1) && "font must return a table");
+
+    font f{};
+    f.glyphs.fill(atlas::none);
+
+    lua_getfield(L, -1, "atlas");
+    const std::string_view atlas_name = luaL_checkstring(L, -1);
+    f.atlas = atlasregistry.resolve(hash(atlas_name));
+    lua_pop(L, 1);
+
+    std::string prefix;
+    lua_getfield(L, -1, "prefix");
+    if (lua_isstring(L, -1)) prefix = lua_tostring(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "spacing");
+    if (lua_isnumber(L, -1)) f.spacing = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "space");
+    if (lua_isnumber(L, -1)) f.space = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "leading");
+    if (lua_isnumber(L, -1)) f.leading = static_cast<float>(lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    const auto& a = atlasregistry.at(f.atlas);
+
+    lua_getfield(L, -1, "characters");
+    const std::string_view characters = luaL_checkstring(L, -1);
+    for (const auto c : characters) {
+      const auto entry = prefix + c;
+      const auto animation = a.resolve(hash(entry));
+      assert(animation != atlas::none && "font glyph not found in atlas");
+      f.glyphs[static_cast<unsigned char>(c)] = a.keyframe(animation, 0);
+    }
+    lua_pop(L, 1);
+
+    lua_pop(L, 1);
+
+    const auto index = static_cast<uint32_t>(fs.entries.size());
+    fs.entries.push_back(f);
+    fs.lookup.emplace(id, index);
+    return index;
+  }
+
+  // Lays the string out left to right from its top-left corner; characters the font lacks advance like a space.
+  void layout(const font& f, const atlas& a, legible& t) {
+    t.dirty = false;
+    t.positions.clear();
+    t.uvs.clear();
+
+    const auto sprites = a.sprites();
+
+    auto pen = t.x;
+    auto line = t.y;
+    auto height = .0f;
+
+    for (const auto c : t.content) {
+      if (c == '\n') {
+        pen = t.x;
+        line += height + f.leading;
+        height = .0f;
+        continue;
+      }
+
+      const auto glyph = f.glyphs[static_cast<unsigned char>(c)];
+      if (glyph == atlas::none) {
+        pen += f.space + f.spacing;
+        continue;
+      }
+
+      const auto& s = sprites[glyph];
+      const auto right = pen + s.w;
+      const auto bottom = line + s.h;
+
+      t.positions.push_back({pen, line});
+      t.positions.push_back({right, line});
+      t.positions.push_back({right, bottom});
+      t.positions.push_back({pen, bottom});
+
+      t.uvs.push_back({s.u0, s.v0});
+      t.uvs.push_back({s.u1, s.v0});
+      t.uvs.push_back({s.u1, s.v1});
+      t.uvs.push_back({s.u0, s.v1});
+
+      pen = right + f.spacing;
+      height = std::max(height, s.h);
+    }
+  }
+
+  int text_index(lua_State* state) {
+    auto* proxy = static_cast<textproxy*>(luaL_checkudata(state, 1, "Text"));
+    if (!proxy->registry->valid(proxy->entity)) return lua_pushnil(state), 1;
+
+    const auto& t = proxy->registry->get<legible>(proxy->entity);
+    const std::string_view key = luaL_checkstring(state, 2);
+
+    if (key == "text") {
+      lua_pushlstring(state, t.content.data(), t.content.size());
+      return 1;
+    }
+
+    if (key == "x") {
+      lua_pushnumber(state, static_cast<double>(t.x));
+      return 1;
+    }
+
+    if (key == "y") {
+      lua_pushnumber(state, static_cast<double>(t.y));
+      return 1;
+    }
+
+    if (key == "alpha") {
+      lua_pushnumber(state, static_cast<double>(t.alpha));
+      return 1;
+    }
+
+    if (key == "shown") {
+      lua_pushboolean(state, t.shown);
+      return 1;
+    }
+
+    return lua_pushnil(state), 1;
+  }
+
+  int text_newindex(lua_State* state) {
+    auto* proxy = static_cast<textproxy*>(luaL_checkudata(state, 1, "Text"));
+    if (!proxy->registry->valid(proxy->entity)) return 0;
+
+    auto& t = proxy->registry->get<legible>(proxy->entity);
+    const std::string_view key = luaL_checkstring(state, 2);
+
+    if (key == "text") {
+      size_t length;
+      const auto* value = luaL_checklstring(state, 3, &length);
+      const std::string_view content{value, length};
+      if (content != t.content) {
+        t.content.assign(content);
+        t.dirty = true;
+      }
+      return 0;
+    }
+
+    if (key == "x") {
+      const auto x = static_cast<float>(luaL_checknumber(state, 3));
+      t.dirty = t.dirty || x != t.x;
+      t.x = x;
+      return 0;
+    }
+
+    if (key == "y") {
+      const auto y = static_cast<float>(luaL_checknumber(state, 3));
+      t.dirty = t.dirty || y != t.y;
+      t.y = y;
+      return 0;
+    }
+
+    if (key == "alpha") {
+      t.alpha = static_cast<uint8_t>(luaL_checknumber(state, 3));
+      return 0;
+    }
+
+    if (key == "shown") {
+      t.shown = lua_toboolean(state, 3) != 0;
+      return 0;
+    }
+
+    return 0;
+  }
+
+  void init() {
+    luaL_newmetatable(L, "Text");
+
+    lua_pushcfunction(L, text_index);
+    lua_setfield(L, -2, "__index");
+
+    lua_pushcfunction(L, text_newindex);
+    lua_setfield(L, -2, "__newindex");
+
+    lua_pop(L, 1);
+  }
+}
+
+void typesetter::wire() {
+  static std::once_flag once;
+  std::call_once(once, init);
+}
+
+entt::entity typesetter::create(entt::registry& registry, atlasregistry& atlasregistry, std::string_view face, std::string_view content, float x, float y) {
+  if (!registry.ctx().contains<fonts>()) registry.ctx().emplace<fonts>();
+
+  const auto entity = registry.create();
+  auto& t = registry.emplace<legible>(entity);
+  t.face = load(registry, atlasregistry, face);
+  t.content = content;
+  t.x = x;
+  t.y = y;
+
+  return entity;
+}
+
+void typesetter::draw(entt::registry& registry, atlasregistry& atlasregistry, compositor& compositor) {
+  if (!registry.ctx().contains<fonts>()) return;
+
+  const auto& fs = registry.ctx().get<fonts>();
+
+  for (auto&& [entity, t] : registry.view<legible>().each()) {
+    if (!t.shown || t.alpha == 0) continue;
+
+    const auto& f = fs.entries[t.face];
+    auto& a = atlasregistry.at(f.atlas);
+
+    if (t.dirty) layout(f, a, t);
+    if (t.positions.empty()) continue;
+
+    atlasregistry.require(a);
+    compositor.mesh(a, t.positions, t.uvs, projection{}, t.alpha);
+  }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "common.hpp"
+
+class atlasregistry;
+class compositor;
+
+namespace typesetter {
+  void wire();
+  entt::entity create(entt::registry& registry, atlasregistry& atlasregistry, std::string_view face, std::string_view content, float x, float y);
+  void draw(entt::registry& registry, atlasregistry& atlasregistry, compositor& compositor);
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <print>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <SDL3/SDL.h>
+#include <entt/entt.hpp>
+#include <lua.hpp>
+#include <physfs.h>
+
+#include "atlas.hpp"
+#include "atlasregistry.hpp"
+#include "camera.hpp"
+#include "compositor.hpp"
+#include "filesystem.hpp"
+#include "trigonometry.hpp"
+
+// pincel-bench <cartridge> [atlas] [--quads N] [--rounds N]
+//
+// Times the compositor's two ways of building quads on a fixed sprite set:
+// one compositor::push per sprite, as layers are baked, against gathering
+// them into a compositor::bulk and handing it to compositor::submit, as
+// presenter::render does. Sprites come from the named atlas of the cartridge
+// (the first one when omitted) and are laid out from a fixed seed, every
+// fourth one rotated and scaled, so runs on different builds are comparable.
+//
+// Only quad assembly is timed. Each round is flushed untimed into a
+// software renderer, so the GPU and the display play no part.
+
+namespace {
+  struct quad final {
+    uint32_t sprite;
+    float x, y, scale, angle;
+    uint8_t alpha;
+  };
+
+  template <typename F>
+  double measure(compositor& compositor, size_t rounds, F&& build) {
+    auto elapsed = .0;
+    for (auto round = 0uz; round < rounds; ++round) {
+      const auto start = SDL_GetPerformanceCounter();
+      build();
+      elapsed += static_cast<double>(SDL_GetPerformanceCounter() - start);
+
+      compositor.flush();
+    }
+
+    return elapsed * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::println(stderr, "usage: pincel-bench <cartridge> [atlas] [--quads N] [--rounds N]");
+    return 1;
+  }
+
+  std::string_view name;
+  auto count = 20000uz;
+  auto rounds = 200uz;
+
+  for (auto i = 2; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--quads" && i + 1 < argc) {
+      count = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--rounds" && i + 1 < argc) {
+      rounds = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      name = arg;
+    }
+  }
+
+  PHYSFS_init(argv[0]);
+  L = luaL_newstate();
+  luaL_openlibs(L);
+
+  const std::unique_ptr<SDL_Surface, decltype(&SDL_DestroySurface)> surface(
+    SDL_CreateSurface(1920, 1080, SDL_PIXELFORMAT_RGBA32),
+    &SDL_DestroySurface
+  );
+  renderer = SDL_CreateSoftwareRenderer(surface.get());
+
+  auto result = 0;
+
+  try {
+    filesystem::mount(argv[1], "/");
+
+    atlasregistry atlases(std::numeric_limits<size_t>::max());
+    auto& a = atlases.at(name.empty() ? 0 : atlases.resolve(entt::hashed_string::value(name.data(), name.size())));
+    atlases.require(a);
+
+    const auto sprites = a.sprites();
+    if (sprites.empty()) throw std::runtime_error("atlas has no sprites");
+
+    std::minstd_rand random{42};
+    std::uniform_real_distribution<float> x{.0f, 1920.0f};
+    std::uniform_real_distribution<float> y{.0f, 1080.0f};
+    std::uniform_real_distribution<float> angle{.0f, 360.0f};
+
+    std::vector<quad> quads(count);
+    for (auto i = 0uz; i < count; ++i) {
+      const auto turned = i % 4 == 0;
+      quads[i] = {
+        static_cast<uint32_t>(i % sprites.size()),
+        x(random),
+        y(random),
+        turned ? 1.5f : 1.0f,
+        turned ? angle(random) : .0f,
+        static_cast<uint8_t>(i % 8 == 0 ? 128 : 255)
+      };
+    }
+
+    compositor compositor;
+
+    const auto pushed = measure(compositor, rounds, [&] {
+      for (const auto& q : quads) {
+        const auto rotated = q.angle != .0f;
+        compositor.push(a, sprites[q.sprite], q.x, q.y, q.scale, rotated ? lcos(q.angle) : 1.0f, rotated ? lsin(q.angle) : .0f, q.alpha);
+      }
+    });
+
+    const auto submitted = measure(compositor, rounds, [&] {
+      auto& bulk = compositor.staging();
+      bulk.clear();
+      for (const auto& q : quads) {
+        const auto rotated = q.angle != .0f;
+        bulk.push(sprites[q.sprite], q.x, q.y, q.scale, rotated ? lcos(q.angle) : 1.0f, rotated ? lsin(q.angle) : .0f, q.alpha);
+      }
+      compositor.submit(a, bulk);
+    });
+
+    const auto total = static_cast<double>(count * rounds);
+    std::println("{} quads x {} rounds", count, rounds);
+    std::println("push   {:10.0f} quads/ms", total / pushed);
+    std::println("submit {:10.0f} quads/ms ({:.2f}x)", total / submitted, pushed / submitted);
+  } catch (const std::exception& e) {
+    std::println(stderr, "{}", e.what());
+    result = 1;
+  }
+
+  SDL_DestroyRenderer(renderer);
+  lua_close(L);
+  PHYSFS_deinit();
+
+  return result;
+}
@@ -0,0 +1,565 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <lua.hpp>
+#include <spng.h>
+
+#include "compat.hpp"
+
+// pincel-pack <input> <output> [--size N] [--padding N]
+//
+// <input> holds loose sprite images (*.png) and an atlas.lua describing
+// the entries to build from them:
+//
+//   return {
+//     idle = { frames = { "idle_0", "idle_1" }, duration = 200, hitbox = { 0, 0, 13, 18 } },
+//     jump = { frames = { "jump_0", "jump_1" }, durations = { 80, 120 }, next = "idle" },
+//     sign = { frames = { "sign" } },
+//     wolf = { frames = { "wolf" }, hitbox = { { 0, 4, 12, 8 }, { 10, 0, 6, 6 } } },
+//   }
+//
+// A hitbox is one { x, y, w, h } or a list of up to four of them. Entries
+// with a single frame and no duration become plain sprites. Every
+// frame is trimmed by the same amount on opposite edges, so its centre, and
+// therefore where the engine draws it, does not move. Pages are written as
+// <name>.png/.lua/.idx, <name>-1.png/.lua/.idx and so on. The .lua uses the
+// { x, y, w, h, hx, hy, hw, hh, ..., duration } format, four fields per hitbox;
+// the .idx is the same data in the binary layout the engine loads in preference to it.
+
+namespace {
+  constexpr auto capacity = 4uz;
+
+  using box = std::array<float, 4>;
+
+  struct image final {
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> pixels;
+  };
+
+  struct rect final {
+    uint32_t x{}, y{}, w{}, h{};
+  };
+
+  struct frame final {
+    std::string source;
+    rect trim;
+    rect placed;
+    std::vector<box> hitboxes;
+    uint32_t duration{};
+  };
+
+  struct entry final {
+    std::string name;
+    std::vector<frame> frames;
+    std::string next;
+    bool once{};
+    bool sprite{};
+    size_t page{};
+  };
+
+  struct shelf final {
+    uint32_t y{};
+    uint32_t height{};
+    uint32_t x{};
+  };
+
+  struct page final {
+    std::vector<shelf> shelves;
+    uint32_t width{};
+    uint32_t height{};
+  };
+
+  struct options final {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    uint32_t size{2048};
+    uint32_t padding{1};
+  };
+
+  std::vector<uint8_t> slurp(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error(std::format("cannot open {}", path.string()));
+
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  }
+
+  image decode(const std::filesystem::path& path) {
+    const auto png = slurp(path);
+
+    const auto ctx = std::unique_ptr<spng_ctx, decltype(&spng_ctx_free)>(spng_ctx_new(0), &spng_ctx_free);
+    spng_set_png_buffer(ctx.get(), png.data(), png.size());
+
+    spng_ihdr ihdr;
+    if (spng_get_ihdr(ctx.get(), &ihdr) != 0)
+      throw std::runtime_error(std::format("{} is not a valid png", path.string()));
+
+    size_t length;
+    spng_decoded_image_size(ctx.get(), SPNG_FMT_RGBA8, &length);
+
+    image result{ihdr.width, ihdr.height, std::vector<uint8_t>(length)};
+    if (spng_decode_image(ctx.get(), result.pixels.data(), length, SPNG_FMT_RGBA8, SPNG_DECODE_TRNS) != 0)
+      throw std::runtime_error(std::format("failed to decode {}", path.string()));
+
+    return result;
+  }
+
+  void encode(const std::filesystem::path& path, const image& img) {
+    const auto ctx = std::unique_ptr<spng_ctx, decltype(&spng_ctx_free)>(spng_ctx_new(SPNG_CTX_ENCODER), &spng_ctx_free);
+    spng_set_option(ctx.get(), SPNG_ENCODE_TO_BUFFER, 1);
+
+    spng_ihdr ihdr{};
+    ihdr.width = img.width;
+    ihdr.height = img.height;
+    ihdr.bit_depth = 8;
+    ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
+    spng_set_ihdr(ctx.get(), &ihdr);
+
+    if (spng_encode_image(ctx.get(), img.pixels.data(), img.pixels.size(), SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE) != 0)
+      throw std::runtime_error(std::format("failed to encode {}", path.string()));
+
+    size_t size;
+    int error;
+    const auto buffer = std::unique_ptr<void, decltype(&std::free)>(spng_get_png_buffer(ctx.get(), &size, &error), &std::free);
+    if (!buffer || error != 0)
+      throw std::runtime_error(std::format("failed to encode {}", path.string()));
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(static_cast<const char*>(buffer.get()), static_cast<std::streamsize>(size));
+  }
+
+  // Shrinks the frame by the same amount on opposite edges, keeping its centre in place.
+  rect trim(const image& img) {
+    auto left = img.width, top = img.height, right = 0u, bottom = 0u;
+
+    for (auto y = 0u; y < img.height; ++y) {
+      for (auto x = 0u; x < img.width; ++x) {
+        if (img.pixels[(static_cast<size_t>(y) * img.width + x) * 4 + 3] == 0) continue;
+
+        left = std::min(left, x);
+        top = std::min(top, y);
+        right = std::max(right, x + 1);
+        bottom = std::max(bottom, y + 1);
+      }
+    }
+
+    if (left >= right || top >= bottom) return {0, 0, img.width, img.height};
+
+    const auto tx = std::min(left, img.width - right);
+    const auto ty = std::min(top, img.height - bottom);
+    return {tx, ty, img.width - tx * 2, img.height - ty * 2};
+  }
+
+  bool place(page& p, rect& r, uint32_t size, uint32_t padding) {
+    const auto w = r.w + padding * 2;
+    const auto h = r.h + padding * 2;
+    if (w > size || h > size) return false;
+
+    for (auto& s : p.shelves) {
+      if (h <= s.height && s.x + w <= size) {
+        r.x = s.x + padding;
+        r.y = s.y + padding;
+        s.x += w;
+        p.width = std::max(p.width, s.x);
+        return true;
+      }
+    }
+
+    const auto y = p.shelves.empty() ? 0u : p.shelves.back().y + p.shelves.back().height;
+    if (y + h > size) return false;
+
+    p.shelves.push_back({y, h, w});
+    r.x = padding;
+    r.y = y + padding;
+    p.width = std::max(p.width, w);
+    p.height = y + h;
+    return true;
+  }
+
+  std::vector<std::string> strings(lua_State* state, int index) {
+    std::vector<std::string> result;
+    const auto count = static_cast<int>(lua_objlen(state, index));
+    for (int i = 1; i <= count; ++i) {
+      lua_rawgeti(state, index, i);
+      result.emplace_back(luaL_checkstring(state, -1));
+      lua_pop(state, 1);
+    }
+    return result;
+  }
+
+  std::vector<double> numbers(lua_State* state, int index) {
+    std::vector<double> result;
+    const auto count = static_cast<int>(lua_objlen(state, index));
+    for (int i = 1; i <= count; ++i) {
+      lua_rawgeti(state, index, i);
+      result.push_back(luaL_checknumber(state, -1));
+      lua_pop(state, 1);
+    }
+    return result;
+  }
+
+  std::vector<entry> describe(const std::filesystem::path& filename) {
+    const auto state = std::unique_ptr<lua_State, decltype(&lua_close)>(luaL_newstate(), &lua_close);
+    auto* const L = state.get();
+
+    if (luaL_dofile(L, filename.string().c_str()) != 0)
+      throw std::runtime_error(lua_tostring(L, -1));
+
+    if (!lua_istable(L, -1))
+      throw std::runtime_error(std::format("{} must return a table", filename.string()));
+
+    std::vector<entry> entries;
+
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0) {
+      // luaL_checkstring would turn a numeric key into a string in place and break lua_next.
+      if (lua_type(L, -2) != LUA_TSTRING)
+        throw std::runtime_error(std::format("{} entries must be named", filename.string()));
+
+      entry e{};
+      e.name = lua_tostring(L, -2);
+
+      lua_getfield(L, -1, "frames");
+      if (!lua_istable(L, -1))
+        throw std::runtime_error(std::format("entry {} must list its frames", e.name));
+      const auto sources = strings(L, lua_gettop(L));
+      lua_pop(L, 1);
+
+      uint32_t duration = 0;
+      lua_getfield(L, -1, "duration");
+      if (lua_isnumber(L, -1)) duration = static_cast<uint32_t>(lua_tonumber(L, -1));
+      lua_pop(L, 1);
+
+      std::vector<double> durations;
+      lua_getfield(L, -1, "durations");
+      if (lua_istable(L, -1)) durations = numbers(L, lua_gettop(L));
+      lua_pop(L, 1);
+
+      std::vector<box> hitboxes;
+      lua_getfield(L, -1, "hitbox");
+      if (lua_istable(L, -1)) {
+        lua_rawgeti(L, -1, 1);
+        const auto nested = lua_istable(L, -1);
+        lua_pop(L, 1);
+
+        const auto count = nested ? static_cast<int>(lua_objlen(L, -1)) : 1;
+        for (int i = 1; i <= count; ++i) {
+          if (nested) lua_rawgeti(L, -1, i);
+          const auto values = numbers(L, lua_gettop(L));
+          if (nested) lua_pop(L, 1);
+
+          if (values.size() != 4)
+            throw std::runtime_error(std::format("entry {} hitbox must be {{ x, y, w, h }}", e.name));
+
+          hitboxes.push_back({static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]), static_cast<float>(values[3])});
+        }
+      }
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "next");
+      if (lua_isstring(L, -1)) e.next = lua_tostring(L, -1);
+      lua_pop(L, 1);
+
+      lua_getfield(L, -1, "once");
+      e.once = lua_toboolean(L, -1) != 0;
+      lua_pop(L, 1);
+
+      if (hitboxes.size() > capacity)
+        throw std::runtime_error(std::format("entry {} has more than {} hitboxes", e.name, capacity));
+
+      for (auto i = 0uz; i < sources.size(); ++i) {
+        frame f{};
+        f.source = sources[i];
+        f.duration = i < durations.size() ? static_cast<uint32_t>(durations[i]) : duration;
+        f.hitboxes = hitboxes;
+        e.frames.push_back(std::move(f));
+      }
+
+      if (e.frames.size() > 1 && std::ranges::all_of(e.frames, [](const frame& f) { return f.duration == 0; }))
+        throw std::runtime_error(std::format("entry {} has several frames but no duration", e.name));
+
+      e.sprite = e.frames.size() == 1 && e.frames[0].duration == 0 && e.next.empty() && !e.once;
+      entries.push_back(std::move(e));
+      lua_pop(L, 1);
+    }
+
+    std::ranges::sort(entries, {}, &entry::name);
+    return entries;
+  }
+
+  // Matches entt::hashed_string, which the engine keys atlas entries by.
+  uint32_t hash(std::string_view value) {
+    auto h = 2166136261u;
+    for (const auto c : value) h = (h ^ static_cast<uint32_t>(c)) * 16777619u;
+    return h;
+  }
+
+  template <typename T>
+  void put(std::string& out, T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  std::string key(std::string_view name) {
+    const auto identifier = !name.empty()
+      && !std::isdigit(static_cast<unsigned char>(name.front()))
+      && std::ranges::all_of(name, [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+
+    return identifier ? std::string{name} : std::format("[\"{}\"]", name);
+  }
+
+  std::string boxes(const frame& f) {
+    std::string out;
+    for (const auto& [hx, hy, hw, hh] : f.hitboxes) out += std::format(", {}, {}, {}, {}", hx, hy, hw, hh);
+    return out;
+  }
+
+  std::string stem(const std::string& name, size_t index) {
+    return index == 0 ? name : std::format("{}-{}", name, index);
+  }
+
+  void emit(const std::filesystem::path& path, const std::vector<entry>& entries, size_t index) {
+    std::string out = "return {\n";
+
+    for (const auto& e : entries) {
+      if (e.page != index) continue;
+
+      if (e.sprite) {
+        const auto& f = e.frames[0];
+        out += std::format("  {} = {{ {}, {}, {}, {}{} }},\n",
+          key(e.name), f.placed.x, f.placed.y, f.placed.w, f.placed.h, boxes(f));
+        continue;
+      }
+
+      out += std::format("  {} = {{\n", key(e.name));
+      for (const auto& f : e.frames) {
+        out += std::format("    {{ {}, {}, {}, {}{}, {} }},\n",
+          f.placed.x, f.placed.y, f.placed.w, f.placed.h, boxes(f), f.duration);
+      }
+      if (!e.next.empty()) out += std::format("    next = \"{}\",\n", e.next);
+      if (e.once) out += "    once = true,\n";
+      out += "  },\n";
+    }
+
+    out += "}\n";
+
+    std::ofstream file(path, std::ios::binary);
+    file << out;
+  }
+
+  // Mirrors the engine's atlas index: "PAI2", width, height, animation, keyframe and hitbox counts,
+  // then { id, offset, count, next, once } per entry, { u0, v0, u1, v1, w, h, first, count, duration }
+  // per frame and { hx, hy, hw, hh } per hitbox.
+  void catalog(const std::filesystem::path& path, const std::vector<entry>& entries, size_t index, uint32_t width, uint32_t height) {
+    constexpr auto none = std::numeric_limits<uint32_t>::max();
+
+    std::vector<const entry*> members;
+    for (const auto& e : entries) {
+      if (e.page == index) members.push_back(&e);
+    }
+
+    const auto position = [&](std::string_view name) {
+      const auto it = std::ranges::find(members, name, &entry::name);
+      return it == members.end() ? none : static_cast<uint32_t>(it - members.begin());
+    };
+
+    uint32_t keyframes = 0;
+    uint32_t hitboxes = 0;
+    for (const auto* e : members) {
+      keyframes += static_cast<uint32_t>(e->frames.size());
+      for (const auto& f : e->frames) hitboxes += static_cast<uint32_t>(f.hitboxes.size());
+    }
+
+    std::string out = "PAI2";
+    put(out, width);
+    put(out, height);
+    put(out, static_cast<uint32_t>(members.size()));
+    put(out, keyframes);
+    put(out, hitboxes);
+
+    uint32_t offset = 0;
+    for (const auto* e : members) {
+      auto next = none;
+      if (!e->next.empty()) {
+        next = position(e->next);
+        if (next == none)
+          throw std::runtime_error(std::format("entry {} continues into {}, which is not on the same page", e->name, e->next));
+      }
+
+      put(out, hash(e->name));
+      put(out, offset);
+      put(out, static_cast<uint32_t>(e->frames.size()));
+      put(out, next);
+      put(out, static_cast<uint32_t>(e->once));
+      offset += static_cast<uint32_t>(e->frames.size());
+    }
+
+    const auto fw = static_cast<float>(width);
+    const auto fh = static_cast<float>(height);
+
+    uint32_t first = 0;
+    for (const auto* e : members) {
+      for (const auto& f : e->frames) {
+        const auto x = static_cast<float>(f.placed.x);
+        const auto y = static_cast<float>(f.placed.y);
+        const auto w = static_cast<float>(f.placed.w);
+        const auto h = static_cast<float>(f.placed.h);
+
+        put(out, x / fw);
+        put(out, y / fh);
+        put(out, (x + w) / fw);
+        put(out, (y + h) / fh);
+        put(out, w);
+        put(out, h);
+        put(out, first);
+        put(out, static_cast<uint32_t>(f.hitboxes.size()));
+        put(out, f.duration);
+        first += static_cast<uint32_t>(f.hitboxes.size());
+      }
+    }
+
+    for (const auto* e : members) {
+      for (const auto& f : e->frames) {
+        for (const auto& b : f.hitboxes) {
+          for (const auto value : b) put(out, value);
+        }
+      }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+  }
+
+  options parse(int argc, char** argv) {
+    options o{};
+    std::vector<std::string_view> positional;
+
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (arg == "--size" && i + 1 < argc) {
+        o.size = static_cast<uint32_t>(std::stoul(argv[++i]));
+      } else if (arg == "--padding" && i + 1 < argc) {
+        o.padding = static_cast<uint32_t>(std::stoul(argv[++i]));
+      } else {
+        positional.push_back(arg);
+      }
+    }
+
+    if (positional.size() != 2)
+      throw std::runtime_error("usage: pincel-pack <input> <output> [--size N] [--padding N]");
+
+    o.input = positional[0];
+    o.output = positional[1];
+    return o;
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    const auto o = parse(argc, argv);
+    const auto name = std::filesystem::absolute(o.input).filename().string();
+
+    auto entries = describe(o.input / "atlas.lua");
+
+    std::unordered_map<std::string, image> images;
+    for (auto& e : entries) {
+      for (auto& f : e.frames) {
+        auto [it, inserted] = images.try_emplace(f.source);
+        if (inserted) it->second = decode(o.input / (f.source + ".png"));
+
+        f.trim = trim(it->second);
+        f.placed = f.trim;
+        for (auto& b : f.hitboxes) {
+          b[0] -= static_cast<float>(f.trim.x);
+          b[1] -= static_cast<float>(f.trim.y);
+        }
+      }
+    }
+
+    // Tallest entries first; an entry's frames always share one page.
+    std::vector<entry*> order;
+    for (auto& e : entries) order.push_back(&e);
+    std::ranges::stable_sort(order, std::ranges::greater{}, [](const entry* e) {
+      uint32_t h = 0;
+      for (const auto& f : e->frames) h = std::max(h, f.trim.h);
+      return h;
+    });
+
+    std::vector<page> pages;
+    for (auto* e : order) {
+      auto placed = false;
+
+      for (auto p = 0uz; p <= pages.size() && !placed; ++p) {
+        if (p == pages.size()) pages.emplace_back();
+
+        auto candidate = pages[p];
+        auto fits = true;
+        for (auto& f : e->frames) {
+          if (!place(candidate, f.placed, o.size, o.padding)) {
+            fits = false;
+            break;
+          }
+        }
+
+        if (fits) {
+          pages[p] = std::move(candidate);
+          e->page = p;
+          placed = true;
+        } else if (pages[p].shelves.empty()) {
+          throw std::runtime_error(std::format("entry {} does not fit in a {}x{} page", e->name, o.size, o.size));
+        }
+      }
+    }
+
+    std::filesystem::create_directories(o.output);
+
+    for (auto p = 0uz; p < pages.size(); ++p) {
+      image out{pages[p].width, pages[p].height, {}};
+      out.pixels.assign(static_cast<size_t>(out.width) * out.height * 4, 0);
+
+      for (const auto& e : entries) {
+        if (e.page != p) continue;
+
+        for (const auto& f : e.frames) {
+          const auto& src = images.at(f.source);
+          for (auto y = 0u; y < f.trim.h; ++y) {
+            const auto* from = src.pixels.data() + (static_cast<size_t>(f.trim.y + y) * src.width + f.trim.x) * 4;
+            auto* to = out.pixels.data() + (static_cast<size_t>(f.placed.y + y) * out.width + f.placed.x) * 4;
+            std::copy_n(from, static_cast<size_t>(f.trim.w) * 4, to);
+          }
+        }
+      }
+
+      const auto base = stem(name, p);
+      encode(o.output / (base + ".png"), out);
+      emit(o.output / (base + ".lua"), entries, p);
+      catalog(o.output / (base + ".idx"), entries, p, out.width, out.height);
+
+      std::println("{}: {}x{}", base, out.width, out.height);
+    }
+
+    for (const auto& e : entries) {
+      if (e.page != 0) std::println("{} -> {}", e.name, stem(name, e.page));
+    }
+  } catch (const std::exception& e) {
+    std::println(stderr, "{}", e.what());
+    return 1;
+  }
+
+  return 0;
+}